@@ -6,13 +6,22 @@ echo "==================================="
 
 # Compile main program
 echo "Compiling vmm.c..."
-gcc -o vmm vmm.c -lm -w
+gcc -rdynamic -o vmm vmm.c -lm -lpthread -ldl -w
 if [ $? -ne 0 ]; then
     echo "Error: Failed to compile vmm.c"
     exit 1
 fi
 echo "Successfully compiled vmm"
 
+# Compile the live counters viewer (run ./vmmtop in another terminal)
+echo "Compiling vmmtop.c..."
+gcc -o vmmtop vmmtop.c -lm -w
+if [ $? -ne 0 ]; then
+    echo "Error: Failed to compile vmmtop.c"
+    exit 1
+fi
+echo "Successfully compiled vmmtop"
+
 # Create programs directory if it doesn't exist
 mkdir -p programs
 
@@ -6,8 +6,30 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/userfaultfd.h>
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1
+#endif
 #include <time.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "vmm_live.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 int mem_size_kb = 0;
 int page_size_kb = 0;
@@ -16,21 +38,211 @@ int total_frames = 0;
 int page_frame[1024];
 int page_valid[1024];
 int page_on_disk[1024];
+unsigned int resident_map[1024 / 32];   /* bit per page, mirrors page_valid */
 
 int frame_occupied[256];
 char* physical_memory[256];
 int frame_to_page[256];
 
-int fifo_queue[256];
-int fifo_front = 0;
-int fifo_rear = 0;
+int fifo_next[256];             /* arrival order, towards the newest */
+int fifo_prev[256];
+int fifo_head[2] = {-1, -1};    /* oldest frame of each list: 0 anon, 1 file */
+int fifo_tail[2] = {-1, -1};
+long fifo_stamp[256];           /* arrival number, to merge the two lists */
+long fifo_seq = 0;
 
-int lru_time[1024];
-int lru_counter = 0;
+long lru_time[1024];
+long lru_counter = 0;
 
 int clock_hand = 0;
 int ref_bit[1024];
 
+int algo = 0;                   /* 0 FIFO, 1 LRU, 2 Clock, 3 Aging, 4 MGLRU, 5 LeCaR */
+
+/* Aging (NFU): one counter and one reference word per frame, kept as
+ * separate arrays so a tick and the victim search are vector passes */
+unsigned short frame_age[256];
+unsigned short frame_ref[256];  /* 0xFFFF when referenced since the last tick */
+unsigned short frame_vacant[256];   /* 0xFFFF for free frames, ORed into the min search */
+int aging_bits = 8;             /* counter width, 8 or 16 */
+long aging_interval = 64;       /* references between ticks */
+long aging_next_tick = 0;
+
+/* Multi-generational LRU, after the kernel's MGLRU.  Each frame carries the
+ * sequence number of its generation, from min_seq (oldest) to max_seq
+ * (youngest), and faulted pages join the youngest.  Aging opens a new
+ * generation and walks every frame's accessed bit (ref_bit, as a page
+ * table walk would), moving referenced pages into it.  It runs when
+ * eviction finds only MGLRU_MIN_GENS generations left.  Eviction scans the
+ * oldest generation.  A page referenced since the walk is promoted instead
+ * of evicted, and the first unreferenced page goes.
+ *
+ * A page's tier counts how often a scan found it referenced.  An evicted
+ * page leaves a shadow entry with its tier and the eviction count.  A fault
+ * on a page with fewer than total_frames evictions since is a refault of
+ * that tier: the page would have stayed resident in a slightly larger
+ * pool.  Generations here hold only a handful of frames, so this
+ * distance test replaces the kernel's same-generation check.  A tier whose
+ * refault rate is above tier 0's is protected.  Eviction then moves the
+ * page up one generation and one tier down instead of evicting it.  Rates
+ * decay by half at each walk. */
+#define MGLRU_MIN_GENS 2
+#define MGLRU_TIERS 4
+
+long mglru_max_seq = 0;
+long mglru_min_seq = 0;
+long frame_gen[256];
+int frame_tier[256];
+long mglru_evictions = 0;
+long shadow_evicted[1024];      /* mglru_evictions when the page was evicted, -1 none */
+int shadow_tier[1024];
+double tier_evicted[MGLRU_TIERS];
+double tier_refaulted[MGLRU_TIERS];
+
+long mglru_walks = 0;
+long mglru_promotions = 0;
+long mglru_protected = 0;
+long mglru_refaults = 0;
+long mglru_tier_refaults[MGLRU_TIERS];
+
+/* LeCaR: learned mix of an LRU and an LFU expert.  Each eviction follows
+ * one expert, drawn with probability equal to its weight.  The evicted
+ * page goes into that expert's ghost history (the last total_frames pages
+ * it evicted) with its frequency.  A fault on a ghost is the expert's
+ * mistake: the other expert's weight grows by exp(lecar_rate * d^age),
+ * where age counts references since the eviction and d^total_frames is
+ * 0.005.  Weights are kept above LECAR_MIN_WEIGHT so a phase change can
+ * still win an expert back.
+ *
+ * Recency is a doubly linked list of frames, most recent at the head, and
+ * frequency a binary min-heap on (count, last reference), so a hit costs
+ * O(1) plus O(log n).  When reclaim is restricted to one list or process,
+ * the experts scan for their first eligible frame instead. */
+#define LECAR_PHASES 8
+#define LECAR_MIN_WEIGHT 0.01
+
+double lecar_rate = 0.45;       /* learning rate */
+double lecar_discount = 1.0;    /* d, from total_frames */
+double lecar_weight[2];         /* LRU, LFU */
+unsigned long long lecar_rng;
+int lecar_next[256];            /* recency list, towards the tail */
+int lecar_prev[256];
+int lecar_head = -1;
+int lecar_tail = -1;
+int lecar_heap[256];            /* frequency heap of frames */
+int lecar_heap_pos[256];
+int lecar_heap_n = 0;
+long lecar_freq[256];
+long lecar_stamp[256];
+int ghost_expert[1024];         /* 1 LRU, 2 LFU, 0 none */
+long ghost_seq[1024];           /* lecar_ghost_adds[expert] at eviction */
+long ghost_time[1024];
+long ghost_freq[1024];
+long lecar_ghost_adds[2];
+
+long lecar_evictions[2];
+long lecar_ghost_hits[2];
+long lecar_phase_len = LONG_MAX;
+long lecar_accounted = 0;       /* references folded into the phase sums */
+double lecar_phase_sum[LECAR_PHASES];
+long lecar_phase_refs[LECAR_PHASES];
+
+/* Background reclaim (kswapd).  An allocation that leaves fewer than the
+ * low watermark of frames free wakes it; it runs at the next slice
+ * boundary (every kswapd_interval references) and evicts until the high
+ * watermark is free, so most faults find a free frame */
+int kswapd_enabled = 0;
+int kswapd_low = 0;             /* 0 = total_frames / 8, at least 1 */
+int kswapd_high = 0;            /* 0 = twice the low watermark */
+long kswapd_interval = 32;
+int kswapd_low_frames = 0;
+int kswapd_high_frames = 0;
+int kswapd_awake = 0;
+long kswapd_next = 0;
+int free_frame_count = 0;
+
+long direct_reclaims = 0;
+long kswapd_reclaims = 0;
+long kswapd_wakeups = 0;
+double direct_reclaim_ms = 0.0;
+double kswapd_ms = 0.0;
+
+/* Simulated processes and copy-on-write fork ("fork <ref> ..." in
+ * config.txt).  A page number is proc * PROC_PAGES + virtual page, so the
+ * per-page arrays double as per-process page tables.  Until the first fork
+ * there is one process and pages are unchanged.  A fork maps the child's
+ * pages onto the parent's frames and swap slots; a frame mapped more than
+ * once is read-only, and a write through any mapping copies it.  Each frame
+ * records which processes map it (all at the same virtual page), which is
+ * the reverse map eviction walks.  Policy state (FIFO entry, LRU stamp,
+ * reference bit) belongs to one mapping, the frame's owner in frame_to_page. */
+#define MAX_PROCS 4
+#define PROC_PAGES (1024 / MAX_PROCS)
+
+long fork_refs[MAX_PROCS - 1];  /* reference counts at which the running process forks */
+int fork_count = 0;
+int fork_quantum = 64;          /* references a process issues before the next one runs */
+int fork_active = 0;            /* forks configured and the memory model supports them */
+int fork_pages_folded = 0;      /* 1: a workload was capped to PROC_PAGES, 2: a trace aliased */
+int fork_next = 0;
+int nr_procs = 1;
+int frame_refcount[256];        /* page table entries mapping the frame */
+unsigned int frame_procs[256];  /* bit per process mapping it */
+char* cow_scratch = NULL;
+
+long forks_done = 0;
+long cow_faults = 0;
+long shared_mappings = 0;       /* frames saved right now: sum of refcount - 1 */
+long shared_peak = 0;
+double shared_sum = 0.0;        /* shared_mappings summed per reference */
+long cow_swapouts_saved = 0;    /* sharers of a frame evicted to swap, each a write a copying fork would add */
+long cow_swapins_saved = 0;     /* faults served from the swap cache */
+
+/* Page-fault-frequency resident set sizing ("pff 1" in config.txt).  Each
+ * process has a resident-set limit, and a process at its limit replaces
+ * its own pages.  Every pff_window references the limits are
+ * re-evaluated.  A process faulting more than pff_upper times per 1000
+ * references grows by pff_step frames.  One faulting fewer than pff_lower
+ * times shrinks by a step and gives back pages beyond the new limit.
+ * Load control: when the running processes' limits add up to more than the
+ * pool while they fault above pff_upper, the pool is thrashing and the
+ * youngest running process is suspended with the frames it owns swapped
+ * out (it keeps mappings of frames a running process owns).  It resumes
+ * once the pool can hold its limit again.  A frame counts against the
+ * process of its owning mapping. */
+int pff_enabled = 0;
+int pff_window = 500;
+double pff_upper = 50.0;        /* faults per 1000 references */
+double pff_lower = 10.0;
+int pff_step = 0;               /* 0 = an eighth of the frames */
+int pff_min = 2;
+int pff_step_frames = 1;        /* pff_step and pff_min resolved for this run */
+int pff_min_frames = 1;
+long pff_next = 0;
+int rs_limit[MAX_PROCS];
+int proc_frames[MAX_PROCS];     /* frames owned */
+long proc_faults[MAX_PROCS];    /* this window */
+long proc_refs[MAX_PROCS];
+int proc_suspended[MAX_PROCS];
+int reclaim_proc = -1;          /* process being reclaimed from, -1 any */
+
+long pff_grows = 0;
+long pff_shrinks = 0;
+long pff_trims = 0;             /* pages given back on a shrink */
+long pff_suspends = 0;
+long pff_resumes = 0;
+long pff_thrash_windows = 0;
+long pff_ticks = 0;
+double pff_limit_sum = 0.0;     /* running processes' limits summed per window */
+long pff_suspended_refs = 0;    /* process-references spent suspended */
+
+long next_event = 0;            /* lru_counter of the next aging tick, kswapd slice, fork or PFF window */
+
+/* Concurrent mode (--concurrent) */
+int concurrent_max_threads = 64;
+long concurrent_refs = 20000;   /* references per thread */
+int concurrent_pagevec = 15;    /* 0 or 1 = rotate under the LRU lock on every hit */
+
 int page_faults = 0;
 int swaps = 0;
 int swap_ins = 0;
@@ -39,7 +251,224 @@ double total_fault_time = 0.0;
 double total_swap_out_time = 0.0;
 double total_swap_in_time = 0.0;
 
-FILE* disk_store = NULL;
+/* Swap space is a slot array spread over the swap areas.  Slots are handed
+ * out sequentially from a wholly free cluster so a batch of victims lands in
+ * one contiguous extent and goes out in a single pwritev; only when no
+ * cluster is free does allocation fall back to any free slot.  A page
+ * swapped back in keeps its slot while it stays clean, so evicting it again
+ * costs no write; the first write to it releases the slot. */
+#define MAX_SWAP_SLOTS 4096
+#define SWAP_BATCH_MAX 256
+int swap_cluster = 32;          /* slots per cluster */
+int swap_batch = 1;             /* victims gathered per direct reclaim */
+int write_percent = 100;        /* share of references that write their page */
+int swap_total_slots = 0;
+
+/* Block-device models.  An area on the "file" device is timed by its real
+ * I/O on the swap file; on a modelled device the I/O still happens, but its
+ * time comes from the model, so paging cost can be predicted for disks the
+ * host does not have.  Profiles can be redefined or added with
+ * "device_profile <name> <latency us> <seek us> <MB/s> <queue depth> <sigma>". */
+struct device_profile {
+    char name[16];
+    double latency_us;          /* per request: command overhead, rotational delay */
+    double seek_us;             /* full seek across the area; 0 for solid state */
+    double mb_per_s;
+    int queue_depth;            /* requests the device accepts at once */
+    double sigma;               /* lognormal spread of the latency */
+};
+
+#define MAX_DEVICE_PROFILES 8
+struct device_profile device_profiles[MAX_DEVICE_PROFILES] = {
+    { "hdd",  4170.0, 8000.0,  160.0,  32, 0.35 },
+    { "sata",   90.0,    0.0,  520.0,  32, 0.25 },
+    { "nvme",   20.0,    0.0, 3000.0,  64, 0.20 },
+};
+int device_profile_count = 3;
+char swap_device[16] = "file";  /* device of areas that name none */
+int swap_areas_configured = 0;  /* swap_area or swap_device given in config.txt */
+double swap_model_skew_ms = 0.0;    /* modelled minus measured swap time this run */
+
+/* Swap areas ("swap_area <path> <priority> [slots] [device]" in config.txt; the
+ * default is disk_swap.bin alone).  New clusters come from the highest
+ * priority area that has one free, rotating among areas of equal priority
+ * so they are striped.  With more than one area each has an I/O worker
+ * thread, so the runs of one batch that land in different areas are
+ * written in parallel; a single area, and every swap-in, is served inline
+ * since a thread hand-off would only add latency. */
+#define MAX_SWAP_AREAS 8
+
+struct swap_io {
+    int write;
+    struct iovec* iov;
+    int count;
+    off_t offset;
+    double submitted;
+};
+
+struct swap_area_stats {
+    long pages_out;
+    long pages_in;
+    long requests;
+    double busy_ms;
+    double latency_ms;          /* summed from submission to completion */
+    double max_latency_ms;
+    long latency_hist[128];     /* quarter-octave buckets of microseconds */
+};
+
+struct swap_area {
+    char path[256];
+    int priority;
+    int slots;                  /* as configured, 0 = 1024 */
+    int first_slot;
+    int nslots;                 /* rounded up to whole clusters */
+    int next_cluster;           /* where the free cluster search resumes */
+    char device_name[16];       /* empty = swap_device */
+    int device;                 /* index into device_profiles, -1 = file */
+    off_t dev_head;             /* byte offset after the last modelled request */
+    unsigned long long rng;     /* latency draws */
+    FILE* file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    struct swap_io queue[SWAP_BATCH_MAX];
+    int head;
+    int tail;
+    struct swap_area_stats stats;
+};
+
+struct swap_area swap_areas[MAX_SWAP_AREAS];
+int swap_area_count = 0;
+int swap_last_area = -1;        /* area of the last cluster handed out */
+pid_t swap_workers_pid = 0;     /* process the worker threads belong to */
+struct swap_area_stats swap_area_totals[MAX_SWAP_AREAS];    /* over every simulated run */
+int swap_area_runs = 0;         /* runs added into swap_area_totals */
+
+int page_slot[1024];            /* -1 when the page has no copy in swap */
+int page_dirty[1024];           /* resident page differs from its swap copy */
+int slot_page[MAX_SWAP_SLOTS];  /* -1 for a free slot */
+int slot_refs[MAX_SWAP_SLOTS];  /* pages whose copy is the slot (>1 after fork) */
+int slot_frame[MAX_SWAP_SLOTS]; /* swap cache: frame still holding a shared slot, or -1 */
+int cluster_used[MAX_SWAP_SLOTS];   /* slots in use per cluster */
+int swap_cur_cluster = -1;
+int swap_next_slot = 0;
+int swap_pending_page[SWAP_BATCH_MAX];
+char* swap_pending_buf[SWAP_BATCH_MAX];
+unsigned int swap_pending_procs[SWAP_BATCH_MAX];   /* other processes sharing the page */
+int swap_pending = 0;
+
+long swap_write_calls = 0;      /* pwritev calls */
+long swap_clean_drops = 0;      /* evictions served by the existing swap copy */
+long swap_slot_frees = 0;       /* slots released because the page was written */
+long swap_fallback_slots = 0;   /* slots placed outside a fresh cluster */
+
+/* File-backed regions ("file_region <first page> <pages> [write %]" in
+ * config.txt).  Their pages come from a backing data file on first touch
+ * instead of being zero-filled, and stores hit them at the region's own
+ * write percentage (default 0, a read-only mapping).  On eviction a clean
+ * file page is dropped and a dirty one written back to the file; neither
+ * touches swap.  Region pages are virtual page numbers, so forked
+ * processes map the same file.
+ *
+ * Anonymous and file pages are reclaimed from separate lists.  Each
+ * reclaim picks a list in the ratio swappiness : 200 - swappiness, as
+ * vm.swappiness does, and the policy chooses its victim within that list. */
+#define MAX_FILE_REGIONS 8
+
+int file_region_first[MAX_FILE_REGIONS];
+int file_region_pages[MAX_FILE_REGIONS];
+int file_region_writes[MAX_FILE_REGIONS];
+int file_region_count = 0;
+int swappiness = 60;
+char file_device[16] = "";      /* device of the data file; empty = swap_device */
+struct swap_area file_backing;  /* the data file, timed like a swap area */
+int file_backing_kb = 0;        /* page size its contents were written for */
+int page_file[1024];            /* region + 1 for file pages, 0 for anonymous,
+                                 * -(region + 1) once a write gave the process
+                                 * its own (anonymous) copy */
+int file_frames = 0;
+int anon_frames = 0;
+int reclaim_class = -1;         /* list being reclaimed: 0 anon, 1 file, -1 no split */
+long anon_scan_credit = 0;
+long file_scan_credit = 0;
+
+long file_reads = 0;
+long file_writebacks = 0;
+long file_drops = 0;
+long anon_reclaims = 0;
+long file_reclaims = 0;
+double file_io_time = 0.0;
+
+/* Workload options (config.txt keys after the two size lines) */
+unsigned long long workload_seed = 12345;
+long trace_length = 0;          /* 0 = num_pages * 100 */
+int compute_work = 5000;        /* busy-loop iterations per reference */
+int trace_rle = 1;              /* collapse immediate repeats before simulating */
+int workload_pages = 0;         /* synthetic footprint; 0 = 3x the frames */
+long simulated_runs = 0;        /* page accesses actually simulated */
+
+/* NUMA topology; numa_nodes = 1 is the original single flat frame pool */
+#define MAX_NODES 8
+#define NUMA_FIRST_TOUCH 0
+#define NUMA_INTERLEAVE  1
+#define NUMA_PREFERRED   2
+
+int numa_nodes = 1;
+int numa_cpus = 1;
+int numa_quantum = 64;          /* references a CPU issues before the next one runs */
+int numa_policy = NUMA_FIRST_TOUCH;
+int numa_preferred = 0;
+int numa_migrate = 0;           /* AutoNUMA-style migration on repeated remote access */
+int numa_migrate_threshold = 4;
+double numa_local_ns = 80.0;
+double numa_remote_ns = 140.0;
+
+int node_first_frame[MAX_NODES];
+int node_frames[MAX_NODES];
+int frame_node[256];
+int page_hint_node[1024];       /* node that last accessed the page remotely */
+int page_hint_count[1024];
+
+long numa_accesses = 0;
+long numa_remote = 0;
+long numa_migrations = 0;
+double numa_access_ns = 0.0;
+
+/* Slow memory tier (CXL/PMEM class) between the frames and swap;
+ * tier2_frames = 0 disables it and victims go straight to disk */
+int tier2_frames = 0;
+double tier1_ns = 80.0;
+double tier2_ns = 300.0;
+int tier2_promote_hits = 2;     /* slow-tier hits within one window to promote */
+int tier2_window = 1000;        /* references per sampling window */
+int tier2_cooldown = 500;       /* references after demotion before promotion */
+
+char* tier2_memory = NULL;
+int tier2_alloc_frames = 0;     /* size tier2_memory was allocated for */
+int tier2_alloc_kb = 0;
+char* tier2_scratch = NULL;
+int tier2_slot_page[1024];
+int page_tier2_slot[1024];
+int page_tier2_hits[1024];
+long page_tier2_window[1024];
+long page_demoted_at[1024];
+
+long tier1_hits = 0;
+long tier2_hits = 0;
+long tier2_promotions = 0;
+long tier2_demotions = 0;
+long tier2_evictions = 0;
+double tier_access_ns = 0.0;
+
+#define MAX_WORKLOAD_OVERRIDES 16
+char workload_match[MAX_WORKLOAD_OVERRIDES][64];
+char workload_spec[MAX_WORKLOAD_OVERRIDES][256];
+int workload_overrides = 0;
+
+#define NUM_POLICIES 6
+
+char* policy_names[NUM_POLICIES] = { "FIFO", "LRU", "Clock", "Aging", "MGLRU", "LeCaR" };
 
 struct program_info {
     char name[256];
@@ -49,13 +478,84 @@ struct program_info {
     double fifo_time;
     double lru_time;
     double clock_time;
+    double aging_time;
+    double mglru_time;
+    double lecar_time;
     double linux_time;
     double avg_access_time;
-    int total_accesses;
+    long total_accesses;
     double avg_fault_time;
     double avg_swap_out_time;
     double avg_swap_in_time;
     double total_io_time;
+    double remote_ratio;
+    long migrations;
+    double avg_mem_ns;
+    double tier1_hit_rate;
+    double tier2_hit_rate;
+    long promotions;
+    long demotions;
+    long tier2_evictions;
+    double avg_tier_ns;
+    long linux_major_faults;
+    long linux_minor_faults;
+    long linux_swap_in;
+    long linux_swap_out;
+    int linux_status;           /* exit code, or -signal */
+    int linux_limit_mode;
+    long linux_limit_used_kb;
+    char linux_limit_why[96];   /* why that limit mode was used */
+    int pager_ok;
+    double pager_time[3];
+    long pager_faults[3];
+    long pager_minor_faults[3];
+    long pager_swaps[3];
+    long mrc_sampled;
+    int mrc_verified;
+    double mrc_error[3];        /* mean absolute error vs exact, FIFO/LRU/Clock */
+    long simulated_runs;
+    int policy_faults[NUM_POLICIES];    /* FIFO/LRU/Clock/Aging/MGLRU/LeCaR */
+    int policy_cached[NUM_POLICIES];    /* time replayed from the result cache */
+    long direct_reclaims;
+    long kswapd_reclaims;
+    long kswapd_wakeups;
+    double direct_reclaim_ms;
+    double kswapd_ms;
+    long swap_write_calls;
+    long swap_clean_drops;
+    long swap_slot_frees;
+    long swap_fallback_slots;
+    int swap_slots_used;
+    int swap_free_extents;
+    int swap_largest_free;
+    long forks_done;
+    long cow_faults;
+    long shared_peak;
+    double avg_shared;
+    long cow_swapouts_saved;
+    long cow_swapins_saved;
+    long file_reads;
+    long file_writebacks;
+    long file_drops;
+    long anon_reclaims;
+    long file_reclaims;
+    double file_io_time;
+    long pff_grows;
+    long pff_shrinks;
+    long pff_trims;
+    long pff_suspends;
+    long pff_resumes;
+    long pff_thrash_windows;
+    double pff_avg_limit;
+    long pff_suspended_refs;
+    long mglru_walks;
+    long mglru_promotions;
+    long mglru_protected;
+    long mglru_refaults;
+    long mglru_tier_refaults[MGLRU_TIERS];
+    long lecar_evictions[2];
+    long lecar_ghost_hits[2];
+    double lecar_phase_weight[LECAR_PHASES];   /* mean LRU weight */
 };
 
 double get_time_ms(void) {
@@ -64,18 +564,551 @@ double get_time_ms(void) {
     return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
 }
 
+/* Split the frames evenly across nodes; node n owns a contiguous range */
+void numa_setup(void) {
+    int n, f, next = 0;
+    if (numa_nodes < 1) numa_nodes = 1;
+    if (numa_nodes > MAX_NODES) numa_nodes = MAX_NODES;
+    if (numa_cpus < 1) numa_cpus = 1;
+    if (numa_quantum < 1) numa_quantum = 1;
+    for (n = 0; n < numa_nodes; n++) {
+        node_first_frame[n] = next;
+        node_frames[n] = total_frames / numa_nodes + (n < total_frames % numa_nodes ? 1 : 0);
+        for (f = next; f < next + node_frames[n]; f++) {
+            frame_node[f] = n;
+        }
+        next += node_frames[n];
+    }
+    numa_accesses = 0;
+    numa_remote = 0;
+    numa_migrations = 0;
+    numa_access_ns = 0.0;
+}
+
+void tier2_setup(void) {
+    if (tier2_frames > 1024) tier2_frames = 1024;
+    /* Sweeps change the page size between runs; slots are refilled before
+     * they are read, so the old contents need not survive */
+    if (tier2_frames > 0 && (tier2_frames != tier2_alloc_frames || page_size_kb != tier2_alloc_kb)) {
+        char* mem = realloc(tier2_memory, (size_t)tier2_frames * page_size_kb * 1024);
+        char* scratch = realloc(tier2_scratch, (size_t)page_size_kb * 1024);
+        if (mem) tier2_memory = mem;
+        if (scratch) tier2_scratch = scratch;
+        if (mem && scratch) {
+            tier2_alloc_frames = tier2_frames;
+            tier2_alloc_kb = page_size_kb;
+        } else {
+            tier2_frames = 0;
+        }
+    }
+    if (tier2_window < 1) tier2_window = 1;
+    tier1_hits = 0;
+    tier2_hits = 0;
+    tier2_promotions = 0;
+    tier2_demotions = 0;
+    tier2_evictions = 0;
+    tier_access_ns = 0.0;
+}
+
+void update_next_event(void) {
+    next_event = LONG_MAX;
+    if (algo == 3) next_event = aging_next_tick;
+    if (kswapd_awake && kswapd_next < next_event) next_event = kswapd_next;
+    if (fork_active && fork_next < fork_count && fork_refs[fork_next] < next_event) {
+        next_event = fork_refs[fork_next];
+    }
+    if (pff_enabled && pff_next < next_event) next_event = pff_next;
+}
+
+/* Forks need one flat frame pool; NUMA and the slow tier keep their own
+ * per-page state, so forks are ignored with either */
+int forks_supported(void) {
+    /* numa_setup() raises numa_nodes below 1 to 1; stream setup asks
+     * before the first init_memory() */
+    return fork_count > 0 && numa_nodes <= 1 && tier2_frames == 0;
+}
+
+void fork_setup(void) {
+    int i, j;
+    long t;
+    fork_active = forks_supported();
+    for (i = 1; i < fork_count; i++) {
+        for (j = i; j > 0 && fork_refs[j - 1] > fork_refs[j]; j--) {
+            t = fork_refs[j];
+            fork_refs[j] = fork_refs[j - 1];
+            fork_refs[j - 1] = t;
+        }
+    }
+    if (fork_quantum < 1) fork_quantum = 1;
+    if (fork_active) {
+        free(cow_scratch);
+        cow_scratch = malloc(page_size_kb * 1024);
+    }
+    fork_next = 0;
+    nr_procs = 1;
+    forks_done = 0;
+    cow_faults = 0;
+    shared_mappings = 0;
+    shared_peak = 0;
+    shared_sum = 0.0;
+    cow_swapouts_saved = 0;
+    cow_swapins_saved = 0;
+}
+
+/* Process a page belongs to */
+int page_proc(int page) {
+    return fork_active ? page / PROC_PAGES : 0;
+}
+
+void pff_setup(void) {
+    int p;
+    if (pff_window < 1) pff_window = 1;
+    pff_min_frames = pff_min < 1 ? 1 : (pff_min > total_frames ? total_frames : pff_min);
+    pff_step_frames = pff_step > 0 ? pff_step : (total_frames / 8 > 0 ? total_frames / 8 : 1);
+    for (p = 0; p < MAX_PROCS; p++) {
+        rs_limit[p] = total_frames;
+        proc_frames[p] = 0;
+        proc_faults[p] = 0;
+        proc_refs[p] = 0;
+        proc_suspended[p] = 0;
+    }
+    reclaim_proc = -1;
+    pff_next = pff_window;
+    pff_grows = 0;
+    pff_shrinks = 0;
+    pff_trims = 0;
+    pff_suspends = 0;
+    pff_resumes = 0;
+    pff_thrash_windows = 0;
+    pff_ticks = 0;
+    pff_limit_sum = 0.0;
+    pff_suspended_refs = 0;
+}
+
+/* Resolve the watermarks for this frame count; kswapd needs at least one
+ * page resident above the high mark, so it stays off below 3 frames */
+void kswapd_setup(void) {
+    kswapd_low_frames = kswapd_low > 0 ? kswapd_low : total_frames / 8;
+    if (kswapd_low_frames < 1) kswapd_low_frames = 1;
+    kswapd_high_frames = kswapd_high > 0 ? kswapd_high : 2 * kswapd_low_frames;
+    if (kswapd_high_frames > total_frames - 1) kswapd_high_frames = total_frames - 1;
+    if (kswapd_low_frames >= kswapd_high_frames) kswapd_low_frames = kswapd_high_frames - 1;
+    if (kswapd_interval < 1) kswapd_interval = 1;
+    free_frame_count = total_frames;
+    kswapd_awake = 0;
+    direct_reclaims = 0;
+    kswapd_reclaims = 0;
+    kswapd_wakeups = 0;
+    direct_reclaim_ms = 0.0;
+    kswapd_ms = 0.0;
+    update_next_event();
+}
+
+int find_device_profile(char* name) {
+    int d;
+    for (d = 0; d < device_profile_count; d++) {
+        if (strcmp(device_profiles[d].name, name) == 0) return d;
+    }
+    return -1;
+}
+
+int swap_area_add(char* path, int priority, int slots, char* device) {
+    struct swap_area* sa;
+    if (swap_area_count >= MAX_SWAP_AREAS) return 0;
+    sa = &swap_areas[swap_area_count++];
+    memset(sa, 0, sizeof(*sa));
+    snprintf(sa->path, sizeof(sa->path), "%s", path);
+    snprintf(sa->device_name, sizeof(sa->device_name), "%s", device);
+    sa->priority = priority;
+    sa->slots = slots;
+    return 1;
+}
+
+/*
+ * Live counters ("live_stats 1" in config.txt, off by default).  A POSIX
+ * shared-memory segment, /dev/shm/vmm_live, holds one slot per simulating
+ * process: slot 0 for the comparison runs, slot 1 + w for sweep worker w.
+ * The simulator stores its counters into its slot at every batch boundary
+ * and each I/O completion adds to the slot's latency histogram, all with
+ * relaxed atomics, so nothing is added per reference.  vmmtop maps the
+ * segment read-only and shows a run's progress while it executes.  The
+ * layout is in vmm_live.h.  Only one vmm at a time publishes: a second
+ * one leaves a live owner's segment alone and runs unwatched.
+ */
+int live_stats_enabled = 0;
+long live_window = 10000;       /* references per fault-rate window */
+struct live_stats* live = NULL;
+struct live_slot* live_slot = NULL;    /* this process's slot, NULL when off */
+int live_running = 0;           /* between live_begin() and live_end() */
+long live_first_ref = 0;        /* lru_counter where the run's measured part began */
+long live_win_refs = 0;         /* where the current window started */
+long live_win_faults = 0;
+
+void live_close(void) {
+    if (!live) return;
+    if (live->pid == getpid()) shm_unlink(LIVE_SHM_NAME);
+    munmap(live, sizeof(*live));
+    live = NULL;
+    live_slot = NULL;
+}
+
+/* Pid of the process that owns the existing segment, 0 if that process is
+ * gone or the segment is not one of ours */
+long live_owner(void) {
+    struct live_stats* old;
+    long pid = 0;
+    int fd = shm_open(LIVE_SHM_NAME, O_RDONLY, 0);
+    struct stat st;
+    
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct live_stats)) {
+        old = mmap(NULL, sizeof(struct live_stats), PROT_READ, MAP_SHARED, fd, 0);
+        if (old != MAP_FAILED) {
+            if (memcmp(old->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC)) == 0 &&
+                (kill((pid_t)old->pid, 0) == 0 || errno == EPERM)) {
+                pid = old->pid;
+            }
+            munmap(old, sizeof(struct live_stats));
+        }
+    }
+    close(fd);
+    return pid;
+}
+
+/* Create a fresh, zeroed segment.  One left by a run that has exited is
+ * replaced; one whose owner still runs is not.  Without /dev/shm the run
+ * just goes unwatched. */
+void live_open(void) {
+    int fd;
+    long owner;
+    void* p;
+    
+    if (!live_stats_enabled) return;
+    fd = shm_open(LIVE_SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        owner = live_owner();
+        if (owner > 0) {
+            printf("Warning: live counters off, %s is in use by vmm pid %ld\n", LIVE_SHM_NAME, owner);
+            return;
+        }
+        shm_unlink(LIVE_SHM_NAME);
+        fd = shm_open(LIVE_SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd < 0) return;
+    if (ftruncate(fd, sizeof(struct live_stats)) != 0) {
+        close(fd);
+        return;
+    }
+    p = mmap(NULL, sizeof(struct live_stats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return;
+    live = p;
+    live->version = LIVE_VERSION;
+    live->pid = getpid();
+    live->started_ms = (long)get_time_ms();
+    memcpy(live->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC));
+    live_slot = &live->slot[0];
+    atexit(live_close);
+}
+
+/* Point this process at slot n (a sweep worker after fork) */
+void live_use_slot(int n) {
+    if (live) live_slot = &live->slot[n < LIVE_SLOTS ? n : LIVE_SLOTS - 1];
+}
+
+void live_publish(void) {
+    struct live_slot* ls = live_slot;
+    if (!ls || !live_running) return;
+    if (lru_counter - live_win_refs >= live_window) {
+        __atomic_store_n(&ls->window_refs, lru_counter - live_win_refs, __ATOMIC_RELAXED);
+        __atomic_store_n(&ls->window_faults, page_faults - live_win_faults, __ATOMIC_RELAXED);
+        live_win_refs = lru_counter;
+        live_win_faults = page_faults;
+    }
+    __atomic_store_n(&ls->refs, lru_counter - live_first_ref, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->faults, (long)page_faults, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->swaps, (long)swaps, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->swap_ins, (long)swap_ins, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->free_frames, (long)free_frame_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->updated_ms, (long)get_time_ms(), __ATOMIC_RELAXED);
+}
+
+/* Reset the slot for a new run once its state is set up; first_ref is
+ * where the measured part begins (past a warm start) */
+void live_begin(char* name, int policy, long first_ref, long total_refs) {
+    struct live_slot* ls = live_slot;
+    int b;
+    if (!ls) return;
+    __atomic_store_n(&ls->state, 0L, __ATOMIC_RELAXED);
+    strncpy(ls->program, name, sizeof(ls->program) - 1);
+    __atomic_store_n(&ls->policy, (long)policy, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->total_refs, total_refs, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->frames, (long)total_frames, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->window_refs, 0L, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->window_faults, 0L, __ATOMIC_RELAXED);
+    for (b = 0; b < 128; b++) __atomic_store_n(&ls->latency_hist[b], 0L, __ATOMIC_RELAXED);
+    live_first_ref = first_ref;
+    live_win_refs = lru_counter;
+    live_win_faults = page_faults;
+    live_running = 1;
+    live_publish();
+    __atomic_store_n(&ls->pid, (long)getpid(), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ls->run, 1L, __ATOMIC_RELAXED);
+    __atomic_store_n(&ls->state, 1L, __ATOMIC_RELEASE);
+}
+
+void live_end(void) {
+    if (!live_slot) return;
+    live_publish();
+    live_running = 0;
+    __atomic_store_n(&live_slot->state, 2L, __ATOMIC_RELEASE);
+}
+
+void latency_record(struct swap_area_stats* st, double ms) {
+    double us = ms * 1000.0;
+    int b = us < 1.0 ? 0 : (int)(log2(us) * 4) + 1;
+    if (b > 127) b = 127;
+    st->latency_hist[b]++;
+    if (live_slot) __atomic_fetch_add(&live_slot->latency_hist[b], 1L, __ATOMIC_RELAXED);
+}
+
+char* swap_device_name(int a) {
+    return swap_areas[a].device >= 0 ? device_profiles[swap_areas[a].device].name : "file";
+}
+
+/* Upper edge of the bucket holding the p-th quantile, in ms */
+double latency_percentile(struct swap_area_stats* st, double p) {
+    long total = 0, seen = 0;
+    int b;
+    for (b = 0; b < 128; b++) total += st->latency_hist[b];
+    if (total == 0) return 0.0;
+    for (b = 0; b < 128; b++) {
+        seen += st->latency_hist[b];
+        if (seen >= p * total) break;
+    }
+    return pow(2.0, b / 4.0) / 1000.0;
+}
+
+void swap_do_io(struct swap_area* sa, struct swap_io* io) {
+    double start = get_time_ms(), end;
+    
+    if (io->write) pwritev(fileno(sa->file), io->iov, io->count, io->offset);
+    else preadv(fileno(sa->file), io->iov, io->count, io->offset);
+    end = get_time_ms();
+    
+    pthread_mutex_lock(&sa->lock);
+    if (io->write) sa->stats.pages_out += io->count;
+    else sa->stats.pages_in += io->count;
+    if (sa->device < 0) {
+        sa->stats.requests++;
+        sa->stats.busy_ms += end - start;
+        sa->stats.latency_ms += end - io->submitted;
+        if (end - io->submitted > sa->stats.max_latency_ms) sa->stats.max_latency_ms = end - io->submitted;
+        latency_record(&sa->stats, end - io->submitted);
+    }
+    pthread_mutex_unlock(&sa->lock);
+}
+
+/* I/O worker: performs one area's requests in submission order */
+void* swap_area_worker(void* arg) {
+    struct swap_area* sa = arg;
+    struct swap_io io;
+    
+    pthread_mutex_lock(&sa->lock);
+    while (1) {
+        while (sa->head == sa->tail) pthread_cond_wait(&sa->work, &sa->lock);
+        io = sa->queue[sa->head % SWAP_BATCH_MAX];
+        pthread_mutex_unlock(&sa->lock);
+        swap_do_io(sa, &io);
+        pthread_mutex_lock(&sa->lock);
+        sa->head++;
+        pthread_cond_broadcast(&sa->done);
+    }
+    return NULL;
+}
+
+/* Open the swap files and, with several areas, start one worker per area.
+ * Threads do not survive fork(), so a forked sweep worker or pager child
+ * starts its own. */
+void swap_areas_start(void) {
+    int a;
+    if (swap_area_count == 0) swap_area_add("disk_swap.bin", 0, 0, "");
+    for (a = 0; a < swap_area_count; a++) {
+        if (!swap_areas[a].file) swap_areas[a].file = fopen(swap_areas[a].path, "w+b");
+        if (!swap_areas[a].file) {
+            printf("Error: cannot open swap area %s\n", swap_areas[a].path);
+            exit(1);
+        }
+    }
+    if (swap_workers_pid == getpid()) return;
+    for (a = 0; a < swap_area_count; a++) {
+        struct swap_area* sa = &swap_areas[a];
+        pthread_mutex_init(&sa->lock, NULL);
+        pthread_cond_init(&sa->work, NULL);
+        pthread_cond_init(&sa->done, NULL);
+        sa->head = 0;
+        sa->tail = 0;
+        if (swap_area_count > 1) pthread_create(&sa->thread, NULL, swap_area_worker, sa);
+    }
+    swap_workers_pid = getpid();
+}
+
+/* Replace the swap files with private temporary ones (sweep workers run
+ * side by side and must not share slots) */
+void swap_areas_private(void) {
+    int a;
+    if (swap_area_count == 0) swap_area_add("disk_swap.bin", 0, 0, "");
+    for (a = 0; a < swap_area_count; a++) swap_areas[a].file = tmpfile();
+}
+
+void swap_areas_close(void) {
+    int a;
+    for (a = 0; a < swap_area_count; a++) {
+        if (swap_areas[a].file) fclose(swap_areas[a].file);
+        swap_areas[a].file = NULL;
+    }
+}
+
+void swap_setup(void) {
+    int i, a, lowest = 0, next = 0, total = 0;
+    
+    swap_areas_start();
+    if (swap_cluster < 1) swap_cluster = 1;
+    if (swap_cluster > 1024) swap_cluster = 1024;
+    if (swap_batch < 1) swap_batch = 1;
+    if (swap_batch > SWAP_BATCH_MAX) swap_batch = SWAP_BATCH_MAX;
+    if (write_percent < 0) write_percent = 0;
+    if (write_percent > 100) write_percent = 100;
+    
+    /* Areas take consecutive whole-cluster ranges of the slot space.  Every
+     * page must be able to get a slot, so the last lowest-priority area
+     * grows to cover any shortfall below 1024 (the whole page space, which
+     * forked processes split rather than multiply). */
+    for (a = 0; a < swap_area_count; a++) {
+        struct swap_area* sa = &swap_areas[a];
+        sa->nslots = ((sa->slots > 0 ? sa->slots : 1024) + swap_cluster - 1) / swap_cluster * swap_cluster;
+        total += sa->nslots;
+        if (sa->priority <= swap_areas[lowest].priority) lowest = a;
+    }
+    if (total < 1024) {
+        swap_areas[lowest].nslots += (1024 - total + swap_cluster - 1) / swap_cluster * swap_cluster;
+    }
+    for (a = 0; a < swap_area_count; a++) {
+        struct swap_area* sa = &swap_areas[a];
+        if (next + sa->nslots > MAX_SWAP_SLOTS) sa->nslots = (MAX_SWAP_SLOTS - next) / swap_cluster * swap_cluster;
+        sa->first_slot = next;
+        sa->next_cluster = next / swap_cluster;
+        sa->device = find_device_profile(sa->device_name[0] ? sa->device_name : swap_device);
+        sa->dev_head = 0;
+        sa->rng = (workload_seed ^ (0x9E3779B97F4A7C15ULL * (a + 1))) | 1;
+        next += sa->nslots;
+        pthread_mutex_lock(&sa->lock);
+        memset(&sa->stats, 0, sizeof(sa->stats));
+        pthread_mutex_unlock(&sa->lock);
+    }
+    swap_total_slots = next;
+    swap_model_skew_ms = 0.0;
+    
+    for (i = 0; i < MAX_SWAP_SLOTS; i++) {
+        slot_page[i] = -1;
+        slot_refs[i] = 0;
+        slot_frame[i] = -1;
+        cluster_used[i] = 0;
+    }
+    swap_cur_cluster = -1;
+    swap_next_slot = 0;
+    swap_last_area = -1;
+    swap_pending = 0;
+    swap_write_calls = 0;
+    swap_clean_drops = 0;
+    swap_slot_frees = 0;
+    swap_fallback_slots = 0;
+}
+
+/* Mark the file pages and write the data file's contents (each page
+ * filled with its page number, like a zero-filled page) */
+void file_setup(void) {
+    long bytes = (long)page_size_kb * 1024;
+    char* buf;
+    int i, r, v;
+    
+    for (i = 0; i < 1024; i++) {
+        v = fork_active ? i % PROC_PAGES : i;
+        page_file[i] = 0;
+        for (r = 0; r < file_region_count; r++) {
+            if (v >= file_region_first[r] && v < file_region_first[r] + file_region_pages[r]) page_file[i] = r + 1;
+        }
+    }
+    if (swappiness < 0) swappiness = 0;
+    if (swappiness > 200) swappiness = 200;
+    file_frames = 0;
+    anon_frames = 0;
+    reclaim_class = -1;
+    anon_scan_credit = 0;
+    file_scan_credit = 0;
+    file_reads = 0;
+    file_writebacks = 0;
+    file_drops = 0;
+    anon_reclaims = 0;
+    file_reclaims = 0;
+    file_io_time = 0.0;
+    if (file_region_count == 0) return;
+    
+    if (!file_backing.file) {
+        file_backing.file = tmpfile();
+        if (!file_backing.file) {
+            printf("Error: cannot create the file-backed data file\n");
+            exit(1);
+        }
+        pthread_mutex_init(&file_backing.lock, NULL);
+        strcpy(file_backing.path, "(data file)");
+    }
+    if (file_backing_kb != page_size_kb) {
+        buf = malloc(bytes);
+        for (v = 0; v < 1024; v++) {
+            if (!page_file[v]) continue;
+            memset(buf, v, bytes);
+            pwrite(fileno(file_backing.file), buf, bytes, (off_t)v * bytes);
+        }
+        free(buf);
+        file_backing_kb = page_size_kb;
+    }
+    file_backing.nslots = 1024;
+    file_backing.device = find_device_profile(file_device[0] ? file_device : swap_device);
+    file_backing.dev_head = 0;
+    file_backing.rng = (workload_seed ^ 0xD1B54A32D192ED03ULL) | 1;
+    memset(&file_backing.stats, 0, sizeof(file_backing.stats));
+}
+
 void init_memory(void) {
     int i;
     for (i = 0; i < 1024; i++) {
         page_frame[i] = -1;
         page_valid[i] = 0;
         page_on_disk[i] = 0;
+        page_slot[i] = -1;
+        page_dirty[i] = 0;
         lru_time[i] = 0;
         ref_bit[i] = 0;
+        shadow_evicted[i] = -1;
+        ghost_expert[i] = 0;
+        page_hint_node[i] = -1;
+        page_hint_count[i] = 0;
+        page_tier2_slot[i] = -1;
+        page_tier2_hits[i] = 0;
+        page_tier2_window[i] = -1;
+        page_demoted_at[i] = 0;
+        tier2_slot_page[i] = -1;
     }
+    memset(resident_map, 0, sizeof(resident_map));
     for (i = 0; i < 256; i++) {
         frame_occupied[i] = 0;
         frame_to_page[i] = -1;
+        frame_age[i] = 0;
+        frame_ref[i] = 0;
+        frame_vacant[i] = 0xFFFF;
+        frame_refcount[i] = 0;
+        frame_procs[i] = 0;
         if (physical_memory[i]) {
             free(physical_memory[i]);
         }
@@ -84,31 +1117,269 @@ void init_memory(void) {
             memset(physical_memory[i], 0, page_size_kb * 1024);
         }
     }
-    fifo_front = 0;
-    fifo_rear = 0;
+    fifo_head[0] = fifo_head[1] = -1;
+    fifo_tail[0] = fifo_tail[1] = -1;
+    fifo_seq = 0;
     lru_counter = 0;
     clock_hand = 0;
+    if (aging_interval < 1) aging_interval = 1;
+    aging_next_tick = aging_interval;
+    mglru_min_seq = 0;
+    mglru_max_seq = MGLRU_MIN_GENS;
+    mglru_evictions = 0;
+    mglru_walks = 0;
+    mglru_promotions = 0;
+    mglru_protected = 0;
+    mglru_refaults = 0;
+    for (i = 0; i < MGLRU_TIERS; i++) {
+        tier_evicted[i] = 0.0;
+        tier_refaulted[i] = 0.0;
+        mglru_tier_refaults[i] = 0;
+    }
+    lecar_weight[0] = 0.5;
+    lecar_weight[1] = 0.5;
+    lecar_discount = pow(0.005, 1.0 / total_frames);
+    lecar_rng = (workload_seed ^ 0x2545F4914F6CDD1DULL) | 1;
+    lecar_head = -1;
+    lecar_tail = -1;
+    lecar_heap_n = 0;
+    lecar_phase_len = LONG_MAX;
+    lecar_accounted = 0;
+    for (i = 0; i < 2; i++) {
+        lecar_ghost_adds[i] = 0;
+        lecar_evictions[i] = 0;
+        lecar_ghost_hits[i] = 0;
+    }
+    for (i = 0; i < LECAR_PHASES; i++) {
+        lecar_phase_sum[i] = 0.0;
+        lecar_phase_refs[i] = 0;
+    }
+    /* fork_setup() decides from the clamped NUMA and slow-tier settings */
+    numa_setup();
+    tier2_setup();
+    fork_setup();
+    pff_setup();
+    file_setup();
+    kswapd_setup();
+    swap_setup();
     page_faults = 0;
     swaps = 0;
     swap_ins = 0;
     total_fault_time = 0.0;
     total_swap_out_time = 0.0;
     total_swap_in_time = 0.0;
-    
-    if (!disk_store) {
-        disk_store = fopen("disk_swap.bin", "w+b");
-    }
 }
 
+/* The page is on the list being reclaimed and, under PFF, belongs to the
+ * process being reclaimed from */
+int page_on_list(int page) {
+    return (reclaim_class < 0 || (page_file[page] > 0) == reclaim_class) &&
+           (reclaim_proc < 0 || page_proc(page) == reclaim_proc);
+}
+
+int frame_on_list(int frame) {
+    return page_on_list(frame_to_page[frame]);
+}
+
+/* FIFO keeps the anon and file frames on separate lists so reclaiming one
+ * class never walks past the other; the arrival stamps merge them back
+ * into one order when both may be taken */
 void enqueue(int page) {
-    fifo_queue[fifo_rear] = page;
-    fifo_rear = (fifo_rear + 1) % total_frames;
+    int f = page_frame[page], c = page_file[page] > 0;
+    fifo_stamp[f] = fifo_seq++;
+    fifo_next[f] = -1;
+    fifo_prev[f] = fifo_tail[c];
+    if (fifo_tail[c] >= 0) fifo_next[fifo_tail[c]] = f;
+    else fifo_head[c] = f;
+    fifo_tail[c] = f;
+}
+
+void fifo_unlink(int f) {
+    int c = page_file[frame_to_page[f]] > 0;
+    if (fifo_prev[f] >= 0) fifo_next[fifo_prev[f]] = fifo_next[f];
+    else fifo_head[c] = fifo_next[f];
+    if (fifo_next[f] >= 0) fifo_prev[fifo_next[f]] = fifo_prev[f];
+    else fifo_tail[c] = fifo_prev[f];
+}
+
+void fifo_move(int from, int to) {
+    int c = page_file[frame_to_page[to]] > 0;
+    fifo_prev[to] = fifo_prev[from];
+    fifo_next[to] = fifo_next[from];
+    fifo_stamp[to] = fifo_stamp[from];
+    if (fifo_prev[to] >= 0) fifo_next[fifo_prev[to]] = to;
+    else fifo_head[c] = to;
+    if (fifo_next[to] >= 0) fifo_prev[fifo_next[to]] = to;
+    else fifo_tail[c] = to;
+}
+
+/* Oldest frame of list c that may be reclaimed now, -1 if none */
+int fifo_first(int c) {
+    int f;
+    if (reclaim_class >= 0 && reclaim_class != c) return -1;
+    for (f = fifo_head[c]; f >= 0 && !frame_on_list(f); f = fifo_next[f]);
+    return f;
 }
 
 int dequeue(void) {
-    int page = fifo_queue[fifo_front];
-    fifo_front = (fifo_front + 1) % total_frames;
-    return page;
+    int a = fifo_first(0), b = fifo_first(1), f;
+    f = a < 0 || (b >= 0 && fifo_stamp[b] < fifo_stamp[a]) ? b : a;
+    fifo_unlink(f);
+    return frame_to_page[f];
+}
+
+void lecar_unlink(int f) {
+    if (lecar_prev[f] >= 0) lecar_next[lecar_prev[f]] = lecar_next[f];
+    else lecar_head = lecar_next[f];
+    if (lecar_next[f] >= 0) lecar_prev[lecar_next[f]] = lecar_prev[f];
+    else lecar_tail = lecar_prev[f];
+}
+
+void lecar_push_head(int f) {
+    lecar_prev[f] = -1;
+    lecar_next[f] = lecar_head;
+    if (lecar_head >= 0) lecar_prev[lecar_head] = f;
+    else lecar_tail = f;
+    lecar_head = f;
+}
+
+/* Heap order: fewer references first, then the least recent */
+int lecar_before(int a, int b) {
+    return lecar_freq[a] < lecar_freq[b] ||
+           (lecar_freq[a] == lecar_freq[b] && lecar_stamp[a] < lecar_stamp[b]);
+}
+
+void lecar_heap_set(int i, int f) {
+    lecar_heap[i] = f;
+    lecar_heap_pos[f] = i;
+}
+
+void lecar_sift_up(int i) {
+    int f = lecar_heap[i];
+    while (i > 0 && lecar_before(f, lecar_heap[(i - 1) / 2])) {
+        lecar_heap_set(i, lecar_heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    lecar_heap_set(i, f);
+}
+
+void lecar_sift_down(int i) {
+    int f = lecar_heap[i], c;
+    while ((c = 2 * i + 1) < lecar_heap_n) {
+        if (c + 1 < lecar_heap_n && lecar_before(lecar_heap[c + 1], lecar_heap[c])) c++;
+        if (!lecar_before(lecar_heap[c], f)) break;
+        lecar_heap_set(i, lecar_heap[c]);
+        i = c;
+    }
+    lecar_heap_set(i, f);
+}
+
+void lecar_heap_remove(int f) {
+    int i = lecar_heap_pos[f], last = lecar_heap[--lecar_heap_n];
+    if (last == f) return;
+    lecar_heap_set(i, last);
+    lecar_sift_up(i);
+    lecar_sift_down(lecar_heap_pos[last]);
+}
+
+/* A reference to the page in frame f */
+void lecar_touch(int f, long ref) {
+    lecar_freq[f]++;
+    lecar_stamp[f] = ref;
+    lecar_sift_down(lecar_heap_pos[f]);
+    if (lecar_head != f) {
+        lecar_unlink(f);
+        lecar_push_head(f);
+    }
+}
+
+/* NUMA migration: frame to takes over from's place in both structures */
+void lecar_move(int from, int to) {
+    lecar_prev[to] = lecar_prev[from];
+    lecar_next[to] = lecar_next[from];
+    if (lecar_prev[to] >= 0) lecar_next[lecar_prev[to]] = to;
+    else lecar_head = to;
+    if (lecar_next[to] >= 0) lecar_prev[lecar_next[to]] = to;
+    else lecar_tail = to;
+    lecar_freq[to] = lecar_freq[from];
+    lecar_stamp[to] = lecar_stamp[from];
+    lecar_heap_set(lecar_heap_pos[from], to);
+}
+
+/* Fold the references since the last call into the per-phase sums of the
+ * LRU weight */
+void lecar_account(void) {
+    while (lecar_accounted < lru_counter) {
+        long p = lecar_accounted / lecar_phase_len, end = lru_counter;
+        if (p >= LECAR_PHASES - 1) p = LECAR_PHASES - 1;
+        else if ((p + 1) * lecar_phase_len < end) end = (p + 1) * lecar_phase_len;
+        lecar_phase_sum[p] += lecar_weight[0] * (end - lecar_accounted);
+        lecar_phase_refs[p] += end - lecar_accounted;
+        lecar_accounted = end;
+    }
+}
+
+/* Evict for the expert drawn by weight.  A page both experts would evict
+ * teaches nothing and gets no ghost entry. */
+int lecar_victim(void) {
+    int lru = lecar_tail, lfu, e, f, i, pg;
+    double u;
+    
+    lecar_rng ^= lecar_rng << 13;
+    lecar_rng ^= lecar_rng >> 7;
+    lecar_rng ^= lecar_rng << 17;
+    u = (lecar_rng >> 11) / 9007199254740992.0;
+    
+    if (reclaim_class >= 0 || reclaim_proc >= 0) {
+        while (!frame_on_list(lru)) lru = lecar_prev[lru];
+        lfu = -1;
+        for (i = 0; i < lecar_heap_n; i++) {
+            f = lecar_heap[i];
+            if (frame_on_list(f) && (lfu < 0 || lecar_before(f, lfu))) lfu = f;
+        }
+    } else {
+        lfu = lecar_heap[0];
+    }
+    e = u < lecar_weight[0] ? 0 : 1;
+    f = e == 0 ? lru : lfu;
+    pg = frame_to_page[f];
+    lecar_evictions[e]++;
+    if (lru != lfu) {
+        ghost_expert[pg] = e + 1;
+        ghost_seq[pg] = lecar_ghost_adds[e]++;
+        ghost_time[pg] = lru_counter;
+        ghost_freq[pg] = lecar_freq[f];
+    } else {
+        ghost_expert[pg] = 0;
+    }
+    lecar_unlink(f);
+    lecar_heap_remove(f);
+    return pg;
+}
+
+/* A page enters frame f.  A ghost hit shifts weight away from the expert
+ * that evicted it and restores the page's frequency. */
+void lecar_add(int page, int f) {
+    int e = ghost_expert[page] - 1;
+    lecar_freq[f] = 0;
+    if (e >= 0 && lecar_ghost_adds[e] - ghost_seq[page] <= total_frames) {
+        double reward = pow(lecar_discount, (double)(lru_counter - ghost_time[page]));
+        double w;
+        lecar_account();
+        lecar_weight[1 - e] *= exp(lecar_rate * reward);
+        w = lecar_weight[0] / (lecar_weight[0] + lecar_weight[1]);
+        if (w < LECAR_MIN_WEIGHT) w = LECAR_MIN_WEIGHT;
+        if (w > 1.0 - LECAR_MIN_WEIGHT) w = 1.0 - LECAR_MIN_WEIGHT;
+        lecar_weight[0] = w;
+        lecar_weight[1] = 1.0 - w;
+        lecar_freq[f] = ghost_freq[page];
+        lecar_ghost_hits[e]++;
+    }
+    ghost_expert[page] = 0;
+    lecar_stamp[f] = lru_counter;
+    lecar_push_head(f);
+    lecar_heap_set(lecar_heap_n, f);
+    lecar_sift_up(lecar_heap_n++);
 }
 
 int find_free_frame(void) {
@@ -121,10 +1392,91 @@ int find_free_frame(void) {
     return -1;
 }
 
+int find_free_frame_on(int node) {
+    int i;
+    for (i = node_first_frame[node]; i < node_first_frame[node] + node_frames[node]; i++) {
+        if (frame_occupied[i] == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Simulated CPUs take turns issuing numa_quantum references each */
+int current_node(void) {
+    int cpu = (int)((lru_counter / numa_quantum) % numa_cpus);
+    return cpu % numa_nodes;
+}
+
+/* Pick a frame for page according to the placement policy, falling back
+ * to the other nodes in order when the target node is full */
+int numa_alloc_frame(int page) {
+    int target, n, frame;
+    if (numa_policy == NUMA_INTERLEAVE) target = page % numa_nodes;
+    else if (numa_policy == NUMA_PREFERRED) target = numa_preferred % numa_nodes;
+    else target = current_node();
+    for (n = 0; n < numa_nodes; n++) {
+        frame = find_free_frame_on((target + n) % numa_nodes);
+        if (frame != -1) return frame;
+    }
+    return -1;
+}
+
+void numa_migrate_page(int page, int node) {
+    int from = page_frame[page];
+    int to = find_free_frame_on(node);
+    if (to == -1) return;
+    if (physical_memory[from] && physical_memory[to]) {
+        memcpy(physical_memory[to], physical_memory[from], page_size_kb * 1024);
+    }
+    frame_occupied[from] = 0;
+    frame_vacant[from] = 0xFFFF;
+    frame_to_page[from] = -1;
+    frame_occupied[to] = 1;
+    frame_vacant[to] = 0;
+    frame_to_page[to] = page;
+    if (algo == 0) fifo_move(from, to);
+    frame_age[to] = frame_age[from];
+    frame_ref[to] = frame_ref[from];
+    frame_gen[to] = frame_gen[from];
+    frame_tier[to] = frame_tier[from];
+    if (algo == 5) lecar_move(from, to);
+    frame_refcount[to] = frame_refcount[from];
+    frame_procs[to] = frame_procs[from];
+    page_frame[page] = to;
+    numa_migrations++;
+}
+
+/* Charge a resident access to the local or remote node and, when enabled,
+ * migrate pages that keep being touched from the same remote node */
+void numa_account(int page) {
+    int node = current_node();
+    numa_accesses++;
+    if (frame_node[page_frame[page]] == node) {
+        numa_access_ns += numa_local_ns;
+        page_hint_count[page] = 0;
+        return;
+    }
+    numa_remote++;
+    numa_access_ns += numa_remote_ns;
+    if (!numa_migrate) return;
+    if (page_hint_node[page] == node) {
+        page_hint_count[page]++;
+    } else {
+        page_hint_node[page] = node;
+        page_hint_count[page] = 1;
+    }
+    if (page_hint_count[page] >= numa_migrate_threshold) {
+        numa_migrate_page(page, node);
+        page_hint_count[page] = 0;
+    }
+}
+
 int lru_victim(void) {
-    int i, victim = -1, min_time = lru_counter + 1;
+    int i, victim = -1;
+    long min_time = lru_counter + 1;
     for (i = 0; i < total_frames; i++) {
-        if (frame_occupied[i]) {
+        if (frame_occupied[i] && frame_on_list(i)) {
             int pg = frame_to_page[i];
             if (lru_time[pg] < min_time) {
                 min_time = lru_time[pg];
@@ -138,7 +1490,7 @@ int lru_victim(void) {
 int clock_victim(void) {
     while (1) {
         int pg = frame_to_page[clock_hand];
-        if (pg >= 0 && frame_occupied[clock_hand]) {
+        if (pg >= 0 && frame_occupied[clock_hand] && frame_on_list(clock_hand)) {
             if (ref_bit[pg] == 0) {
                 int victim = pg;
                 clock_hand = (clock_hand + 1) % total_frames;
@@ -150,361 +1502,4186 @@ int clock_victim(void) {
     }
 }
 
-void swap_to_disk(int page) {
-    int frame = page_frame[page];
-    if (frame < 0 || !physical_memory[frame]) return;
-    
-    double start = get_time_ms();
-    long pos = (long)page * page_size_kb * 1024;
-    fseek(disk_store, pos, SEEK_SET);
-    fwrite(physical_memory[frame], page_size_kb * 1024, 1, disk_store);
-    fflush(disk_store);
-    double end = get_time_ms();
-    
-    page_on_disk[page] = 1;
-    swaps++;
-    total_swap_out_time += (end - start);
+int cpu_avx2 = -1;              /* -1 until has_avx2() first checks the CPU */
+
+/* The AVX2 paths are compiled whatever the build flags are and only taken
+ * when the CPU has it */
+int has_avx2(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_avx2 < 0) cpu_avx2 = __builtin_cpu_supports("avx2") != 0;
+    return cpu_avx2;
+#else
+    return 0;
+#endif
 }
 
-void read_from_disk(int page, int frame) {
-    if (!page_on_disk[page] || !physical_memory[frame]) return;
-    
-    double start = get_time_ms();
-    long pos = (long)page * page_size_kb * 1024;
-    fseek(disk_store, pos, SEEK_SET);
-    fread(physical_memory[frame], page_size_kb * 1024, 1, disk_store);
-    double end = get_time_ms();
-    
-    swap_ins++;
-    total_swap_in_time += (end - start);
+#if defined(__x86_64__) || defined(__i386__)
+/* aging_tick() sixteen frames at a time; returns the frames done */
+__attribute__((target("avx2")))
+int aging_tick_avx2(unsigned short top) {
+    __m256i top8 = _mm256_set1_epi16((short)top);
+    int i = 0;
+    for (; i + 16 <= total_frames; i += 16) {
+        __m256i age = _mm256_loadu_si256((__m256i*)(frame_age + i));
+        __m256i ref = _mm256_loadu_si256((__m256i*)(frame_ref + i));
+        age = _mm256_or_si256(_mm256_srli_epi16(age, 1), _mm256_and_si256(ref, top8));
+        _mm256_storeu_si256((__m256i*)(frame_age + i), age);
+    }
+    return i;
 }
 
-int algo = 0;
+/* Smallest masked counter of the first *done frames, sixteen at a time */
+__attribute__((target("avx2")))
+unsigned short aging_min_avx2(int* done) {
+    __m256i m8 = _mm256_set1_epi16(-1);
+    __m128i m4;
+    int i = 0;
+    for (; i + 16 <= total_frames; i += 16) {
+        m8 = _mm256_min_epu16(m8, _mm256_or_si256(_mm256_loadu_si256((__m256i*)(frame_age + i)),
+                                                  _mm256_loadu_si256((__m256i*)(frame_vacant + i))));
+    }
+    m4 = _mm_min_epu16(_mm256_castsi256_si128(m8), _mm256_extracti128_si256(m8, 1));
+    m4 = _mm_minpos_epu16(m4);
+    *done = i;
+    return (unsigned short)_mm_cvtsi128_si32(m4);
+}
+#endif
 
-void handle_page_fault(int page) {
-    double fault_start = get_time_ms();
-    int frame = find_free_frame();
-    
-    if (frame == -1) {
-        int victim;
-        if (algo == 1) victim = lru_victim();
-        else if (algo == 2) victim = clock_victim();
-        else victim = dequeue();
-        frame = page_frame[victim];
-        swap_to_disk(victim);
-        page_valid[victim] = 0;
-        page_frame[victim] = -1;
-        frame_to_page[frame] = -1;
-    }
-    
-    if (page_on_disk[page]) {
-        read_from_disk(page, frame);
-    } else {
-        if (physical_memory[frame]) {
-            memset(physical_memory[frame], page, page_size_kb * 1024);
-        }
+/* Shift every frame's counter right and OR its reference bit into the top */
+void aging_tick(void) {
+    unsigned short top = (unsigned short)(1u << (aging_bits - 1));
+    int i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_avx2()) i = aging_tick_avx2(top);
+#endif
+#ifdef __SSE2__
+    __m128i top4 = _mm_set1_epi16((short)top);
+    for (; i + 8 <= total_frames; i += 8) {
+        __m128i age = _mm_loadu_si128((__m128i*)(frame_age + i));
+        __m128i ref = _mm_loadu_si128((__m128i*)(frame_ref + i));
+        age = _mm_or_si128(_mm_srli_epi16(age, 1), _mm_and_si128(ref, top4));
+        _mm_storeu_si128((__m128i*)(frame_age + i), age);
     }
-    
-    page_frame[page] = frame;
-    page_valid[page] = 1;
-    frame_occupied[frame] = 1;
-    frame_to_page[frame] = page;
-    enqueue(page);
-    
-    double fault_end = get_time_ms();
-    total_fault_time += (fault_end - fault_start);
+#endif
+    for (; i < total_frames; i++) {
+        frame_age[i] = (frame_age[i] >> 1) | (frame_ref[i] & top);
+    }
+    memset(frame_ref, 0, sizeof(frame_ref));
+    aging_next_tick += aging_interval;
 }
 
-void access_page(int page) {
-    if (page_valid[page] == 0) {
-        page_faults++;
-        handle_page_fault(page);
+/* aging_victim() restricted to one list: a plain scan, with the same
+ * tie-break */
+int aging_list_victim(void) {
+    unsigned short min_age = 0xFFFF;
+    int i, n;
+    for (i = 0; i < total_frames; i++) {
+        if (frame_occupied[i] && frame_on_list(i) && frame_age[i] < min_age) min_age = frame_age[i];
+    }
+    i = clock_hand;
+    for (n = 0; n < total_frames; n++) {
+        if (frame_occupied[i] && frame_on_list(i) && frame_age[i] == min_age) break;
+        i = (i + 1) % total_frames;
+    }
+    clock_hand = (i + 1) % total_frames;
+    return frame_to_page[i];
+}
+
+/* Evict the frame with the smallest counter.  Free frames (possible while
+ * kswapd keeps some in reserve) are masked to 0xFFFF; ties go to the first
+ * occupied frame at or after clock_hand so equally old pages are taken in
+ * turn rather than always from the low frames. */
+int aging_victim(void) {
+    unsigned short min_age = 0xFFFF;
+    int i = 0, n;
+    
+    if (reclaim_class >= 0 || reclaim_proc >= 0) return aging_list_victim();
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_avx2()) min_age = aging_min_avx2(&i);
+#endif
+#ifdef __SSE2__
+    /* Without the AVX2 pass: SSE2 has only a signed 16-bit min, so flip the
+     * sign bit around it */
+    __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i m4 = _mm_set1_epi16(0x7FFF);
+    if (i == 0) {
+        for (; i + 8 <= total_frames; i += 8) {
+            __m128i age = _mm_or_si128(_mm_loadu_si128((__m128i*)(frame_age + i)),
+                                       _mm_loadu_si128((__m128i*)(frame_vacant + i)));
+            m4 = _mm_min_epi16(m4, _mm_xor_si128(age, bias));
+        }
+        m4 = _mm_min_epi16(m4, _mm_shuffle_epi32(m4, 0x4E));
+        m4 = _mm_min_epi16(m4, _mm_shuffle_epi32(m4, 0xB1));
+        m4 = _mm_min_epi16(m4, _mm_shufflelo_epi16(m4, 0xB1));
+        min_age = (unsigned short)(_mm_extract_epi16(m4, 0) ^ 0x8000);
+    }
+#endif
+    for (; i < total_frames; i++) {
+        if ((frame_age[i] | frame_vacant[i]) < min_age) min_age = frame_age[i] | frame_vacant[i];
+    }
+
+    i = clock_hand;
+    for (n = 0; n < total_frames; n++) {
+        if (frame_occupied[i] && frame_age[i] == min_age) break;
+        i = (i + 1) % total_frames;
+    }
+    clock_hand = (i + 1) % total_frames;
+    return frame_to_page[i];
+}
+
+int swap_area_of(int slot) {
+    int a;
+    for (a = 0; a < swap_area_count - 1; a++) {
+        if (slot < swap_areas[a].first_slot + swap_areas[a].nslots) break;
+    }
+    return a;
+}
+
+/* First wholly free cluster of an area, searching round from where the
+ * last one was found */
+int swap_free_cluster(int a) {
+    int first = swap_areas[a].first_slot / swap_cluster;
+    int count = swap_areas[a].nslots / swap_cluster;
+    int n, c;
+    for (n = 0; n < count; n++) {
+        c = first + (swap_areas[a].next_cluster - first + n) % count;
+        if (cluster_used[c] == 0) return c;
+    }
+    return -1;
+}
+
+/* Next slot of the current cluster; when it runs out, a wholly free
+ * cluster from the highest priority area that has one, taking areas of
+ * equal priority in turn after the one used last; and only when no
+ * cluster is free, any free slot, highest priority first.  Returns -1,
+ * leaving page without a slot, when every slot is taken. */
+int swap_alloc_slot(int page) {
+    int a, c, n, best = -1, slot = -1;
+    
+    if (swap_cur_cluster >= 0) {
+        int end = (swap_cur_cluster + 1) * swap_cluster;
+        while (swap_next_slot < end && slot_page[swap_next_slot] >= 0) swap_next_slot++;
+        if (swap_next_slot < end) slot = swap_next_slot++;
+    }
+    for (n = 1; slot == -1 && n <= swap_area_count; n++) {
+        a = (swap_last_area + n + swap_area_count) % swap_area_count;
+        if (best >= 0 && swap_areas[a].priority <= swap_areas[best].priority) continue;
+        if ((c = swap_free_cluster(a)) >= 0) {
+            best = a;
+            swap_cur_cluster = c;
+        }
+    }
+    if (slot == -1 && best >= 0) {
+        swap_last_area = best;
+        swap_areas[best].next_cluster = swap_cur_cluster + 1;
+        slot = swap_cur_cluster * swap_cluster;
+        swap_next_slot = slot + 1;
+    }
+    if (slot == -1) {
+        for (a = 0; a < swap_area_count; a++) {
+            if (best >= 0 && swap_areas[a].priority <= swap_areas[best].priority) continue;
+            for (c = swap_areas[a].first_slot; c < swap_areas[a].first_slot + swap_areas[a].nslots; c++) {
+                if (slot_page[c] < 0) {
+                    best = a;
+                    slot = c;
+                    break;
+                }
+            }
+        }
+        if (slot == -1) return -1;
+        swap_fallback_slots++;
+    }
+    slot_page[slot] = page;
+    slot_refs[slot] = 1;
+    slot_frame[slot] = -1;
+    cluster_used[slot / swap_cluster]++;
+    page_slot[page] = slot;
+    page_on_disk[page] = 1;
+    return slot;
+}
+
+/* Drop page's reference to its slot; the slot is free once no process's
+ * page refers to it.  Whatever frame cached it is about to diverge or be
+ * reused, so the swap cache entry goes too. */
+void swap_free_slot(int page) {
+    int slot = page_slot[page];
+    page_slot[page] = -1;
+    page_on_disk[page] = 0;
+    slot_frame[slot] = -1;
+    if (--slot_refs[slot] > 0) return;
+    slot_page[slot] = -1;
+    cluster_used[slot / swap_cluster]--;
+    swap_slot_frees++;
+}
+
+void swap_submit(int a, int write, struct iovec* iov, int count, int slot) {
+    struct swap_area* sa = &swap_areas[a];
+    struct swap_io* io;
+    
+    pthread_mutex_lock(&sa->lock);
+    io = &sa->queue[sa->tail % SWAP_BATCH_MAX];
+    io->write = write;
+    io->iov = iov;
+    io->count = count;
+    io->offset = (off_t)(slot - sa->first_slot) * iov[0].iov_len;
+    io->submitted = get_time_ms();
+    sa->tail++;
+    pthread_cond_signal(&sa->work);
+    pthread_mutex_unlock(&sa->lock);
+}
+
+/* Wait until every area's worker has drained its queue */
+void swap_wait(void) {
+    int a;
+    for (a = 0; a < swap_area_count; a++) {
+        struct swap_area* sa = &swap_areas[a];
+        pthread_mutex_lock(&sa->lock);
+        while (sa->head != sa->tail) pthread_cond_wait(&sa->done, &sa->lock);
+        pthread_mutex_unlock(&sa->lock);
+    }
+}
+
+struct dev_req {
+    off_t offset;
+    long bytes;
+};
+
+int dev_req_cmp(const void* a, const void* b) {
+    off_t x = ((struct dev_req*)a)->offset, y = ((struct dev_req*)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+/* Lognormal latency factor with mean 1 */
+double device_jitter(struct swap_area* sa, double sigma) {
+    double u1, u2;
+    if (sigma <= 0) return 1.0;
+    sa->rng ^= sa->rng << 13;
+    sa->rng ^= sa->rng >> 7;
+    sa->rng ^= sa->rng << 17;
+    u1 = ((sa->rng >> 11) + 0.5) / 9007199254740992.0;
+    u2 = ((sa->rng & 0xFFFFF) + 0.5) / 1048576.0;
+    return exp(sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2) - sigma * sigma / 2);
+}
+
+/*
+ * Serve a batch of requests submitted together to one modelled device and
+ * return the time until the last completes, in ms.  The queue takes
+ * queue_depth requests at a time, orders each window C-LOOK from the head
+ * (ascending from the head, then wrapping) and merges requests that become
+ * adjacent.  A seeking device serves the window one request at a time and
+ * skips seek and rotation when a request starts where the last one ended;
+ * solid-state devices keep the whole window in flight.  Transfers share the
+ * device bandwidth either way.
+ */
+double device_service(struct swap_area* sa, struct dev_req* reqs, int n) {
+    struct device_profile* dev = &device_profiles[sa->device];
+    double chan_free[256], xfer_free = 0.0, last = 0.0, span;
+    int qd = dev->queue_depth < 1 ? 1 : (dev->queue_depth > 256 ? 256 : dev->queue_depth);
+    int w, i, j, m, c, k;
+    
+    span = (double)sa->nslots * page_size_kb * 1024;
+    for (i = 0; i < qd; i++) chan_free[i] = 0.0;
+    for (w = 0; w < n; w += qd) {
+        struct dev_req win[256];
+        m = n - w < qd ? n - w : qd;
+        memcpy(win, reqs + w, m * sizeof(*win));
+        qsort(win, m, sizeof(*win), dev_req_cmp);
+        for (k = 0; k < m && win[k].offset < sa->dev_head; k++);
+        for (i = 0, j = 0; i < m; i++) {
+            struct dev_req r = win[(k + i) % m];
+            if (j > 0 && reqs[w + j - 1].offset + reqs[w + j - 1].bytes == r.offset) {
+                reqs[w + j - 1].bytes += r.bytes;
+            } else {
+                reqs[w + j++] = r;
+            }
+        }
+        for (i = 0; i < j; i++) {
+            struct dev_req* r = &reqs[w + i];
+            double start, ready, done;
+            if (dev->seek_us > 0) {
+                start = last;
+            } else {
+                for (c = 0, k = 1; k < qd; k++) {
+                    if (chan_free[k] < chan_free[c]) c = k;
+                }
+                start = chan_free[c];
+            }
+            ready = start;
+            if (dev->seek_us <= 0 || r->offset != sa->dev_head) {
+                ready += dev->latency_us * device_jitter(sa, dev->sigma);
+                if (dev->seek_us > 0) {
+                    ready += dev->seek_us * sqrt(fabs((double)(r->offset - sa->dev_head)) / span);
+                }
+            }
+            if (ready < xfer_free) ready = xfer_free;
+            done = ready + r->bytes / dev->mb_per_s;    /* MB/s = bytes per us */
+            xfer_free = done;
+            if (dev->seek_us <= 0) chan_free[c] = done;
+            sa->dev_head = r->offset + r->bytes;
+            if (done > last) last = done;
+            
+            pthread_mutex_lock(&sa->lock);
+            sa->stats.requests++;
+            sa->stats.latency_ms += done / 1000.0;
+            if (done / 1000.0 > sa->stats.max_latency_ms) sa->stats.max_latency_ms = done / 1000.0;
+            latency_record(&sa->stats, done / 1000.0);
+            pthread_mutex_unlock(&sa->lock);
+        }
+    }
+    pthread_mutex_lock(&sa->lock);
+    sa->stats.busy_ms += last / 1000.0;
+    pthread_mutex_unlock(&sa->lock);
+    return last / 1000.0;
+}
+
+/* Time of a set of requests issued together, given the measured time of
+ * their real I/O: areas work in parallel, so it is the slowest area's
+ * modelled time, or the measured time when a file-timed area took part */
+double swap_model_time(int* areas, struct dev_req* reqs, int n, double measured) {
+    struct dev_req batch[SWAP_BATCH_MAX];
+    double t = 0.0, area_ms;
+    int a, i, m;
+    
+    for (a = 0; a < swap_area_count; a++) {
+        for (i = 0, m = 0; i < n; i++) {
+            if (areas[i] == a) batch[m++] = reqs[i];
+        }
+        if (m == 0) continue;
+        area_ms = swap_areas[a].device >= 0 ? device_service(&swap_areas[a], batch, m) : measured;
+        if (area_ms > t) t = area_ms;
+    }
+    return t;
+}
+
+/* Write the queued pages to consecutive slots, one pwritev per contiguous
+ * run within an area; runs in different areas go out in parallel */
+void swap_flush(void) {
+    struct iovec iov[SWAP_BATCH_MAX];
+    struct dev_req reqs[SWAP_BATCH_MAX];
+    int slots[SWAP_BATCH_MAX], areas[SWAP_BATCH_MAX];
+    long bytes = (long)page_size_kb * 1024;
+    int i, p, run, a, end, nreqs = 0;
+    double start, measured, t;
+    
+    if (swap_pending == 0) return;
+    start = get_time_ms();
+    for (i = 0; i < swap_pending; i++) {
+        slots[i] = swap_alloc_slot(swap_pending_page[i]);
+        if (slots[i] < 0) {
+            /* swap_setup sizes the areas for every page, so this is a bug */
+            printf("Error: no free swap slot for page %d (%d slots)\n", swap_pending_page[i], swap_total_slots);
+            exit(1);
+        }
+        iov[i].iov_base = swap_pending_buf[i];
+        iov[i].iov_len = bytes;
+        for (p = 0; p < MAX_PROCS; p++) {
+            /* The other mappings of a shared frame point at the same slot */
+            int q = p * PROC_PAGES + swap_pending_page[i] % PROC_PAGES;
+            if (!(swap_pending_procs[i] & (1u << p))) continue;
+            if (page_slot[q] >= 0) swap_free_slot(q);
+            page_slot[q] = slots[i];
+            page_on_disk[q] = 1;
+            slot_refs[slots[i]]++;
+        }
+    }
+    for (i = 0; i < swap_pending; i = run) {
+        a = swap_area_of(slots[i]);
+        end = swap_areas[a].first_slot + swap_areas[a].nslots;
+        for (run = i + 1; run < swap_pending && slots[run] == slots[run - 1] + 1 && slots[run] < end; run++);
+        if (swap_area_count > 1) {
+            swap_submit(a, 1, iov + i, run - i, slots[i]);
+        } else {
+            struct swap_io io;
+            io.write = 1;
+            io.iov = iov + i;
+            io.count = run - i;
+            io.offset = (off_t)(slots[i] - swap_areas[a].first_slot) * bytes;
+            io.submitted = get_time_ms();
+            swap_do_io(&swap_areas[a], &io);
+        }
+        areas[nreqs] = a;
+        reqs[nreqs].offset = (off_t)(slots[i] - swap_areas[a].first_slot) * bytes;
+        reqs[nreqs].bytes = (run - i) * bytes;
+        nreqs++;
+        swap_write_calls++;
+    }
+    swap_wait();
+    swaps += swap_pending;
+    swap_pending = 0;
+    measured = get_time_ms() - start;
+    t = swap_model_time(areas, reqs, nreqs, measured);
+    swap_model_skew_ms += t - measured;
+    total_swap_out_time += t;
+}
+
+/* Queue buf as page's new swap copy; the buffer must stay untouched until
+ * swap_flush() */
+void swap_queue(int page, char* buf) {
+    if (swap_pending == SWAP_BATCH_MAX) swap_flush();
+    if (page_slot[page] >= 0) swap_free_slot(page);
+    swap_pending_page[swap_pending] = page;
+    swap_pending_buf[swap_pending] = buf;
+    swap_pending_procs[swap_pending] = 0;
+    swap_pending++;
+}
+
+/* A write to a clean page makes its swap copy stale, so the slot goes back.
+ * Below 100% writes (write_percent, or the file region's own) a fixed hash
+ * of the reference decides whether it writes. */
+int ref_writes(int page, long ref) {
+    int percent = page_file[page] ? file_region_writes[abs(page_file[page]) - 1] : write_percent;
+    return percent >= 100 ||
+           ((unsigned long long)(ref ^ ((long)page << 32)) * 0x9E3779B97F4A7C15ULL >> 40) % 100 <
+           (unsigned long long)percent;
+}
+
+void swap_write_page(int page, long ref) {
+    if (!ref_writes(page, ref)) return;
+    page_dirty[page] = 1;
+    if (page_slot[page] >= 0) swap_free_slot(page);
+}
+
+void read_from_disk(int page, int frame) {
+    struct iovec iov;
+    struct swap_io io;
+    struct dev_req req;
+    int a;
+    double start, measured, t;
+    
+    if (page_slot[page] < 0 || !physical_memory[frame]) return;
+    
+    start = get_time_ms();
+    a = swap_area_of(page_slot[page]);
+    iov.iov_base = physical_memory[frame];
+    iov.iov_len = (long)page_size_kb * 1024;
+    io.write = 0;
+    io.iov = &iov;
+    io.count = 1;
+    io.offset = (off_t)(page_slot[page] - swap_areas[a].first_slot) * iov.iov_len;
+    io.submitted = start;
+    swap_do_io(&swap_areas[a], &io);
+    measured = get_time_ms() - start;
+    req.offset = io.offset;
+    req.bytes = iov.iov_len;
+    t = swap_model_time(&a, &req, 1, measured);
+    
+    swap_model_skew_ms += t - measured;
+    swap_ins++;
+    total_swap_in_time += t;
+}
+
+/* One page of I/O at the page's offset in the data file */
+void file_io(int page, int frame, int write) {
+    struct iovec iov;
+    struct swap_io io;
+    struct dev_req req;
+    double start, measured, t;
+    
+    if (!physical_memory[frame]) return;
+    
+    start = get_time_ms();
+    iov.iov_base = physical_memory[frame];
+    iov.iov_len = (long)page_size_kb * 1024;
+    io.write = write;
+    io.iov = &iov;
+    io.count = 1;
+    io.offset = (off_t)(fork_active ? page % PROC_PAGES : page) * iov.iov_len;
+    io.submitted = start;
+    swap_do_io(&file_backing, &io);
+    measured = get_time_ms() - start;
+    req.offset = io.offset;
+    req.bytes = iov.iov_len;
+    t = file_backing.device >= 0 ? device_service(&file_backing, &req, 1) : measured;
+    
+    swap_model_skew_ms += t - measured;
+    file_io_time += t;
+}
+
+/* Number of free extents in swap, with the free slot count and the
+ * longest extent */
+int swap_free_extents(int* free_slots, int* largest) {
+    int i, run = 0, extents = 0;
+    *free_slots = 0;
+    *largest = 0;
+    for (i = 0; i < swap_total_slots; i++) {
+        if (slot_page[i] >= 0) {
+            run = 0;
+            continue;
+        }
+        (*free_slots)++;
+        if (run++ == 0) extents++;
+        if (run > *largest) *largest = run;
+    }
+    return extents;
+}
+
+char* tier2_slot_data(int slot) {
+    return tier2_memory + (long)slot * page_size_kb * 1024;
+}
+
+/* Write the least recently used slow-tier page to swap, freeing its slot */
+int tier2_evict(void) {
+    int i, victim = -1, slot;
+    long min_time = lru_counter + 1;
+    for (i = 0; i < tier2_frames; i++) {
+        int pg = tier2_slot_page[i];
+        if (pg >= 0 && lru_time[pg] < min_time) {
+            min_time = lru_time[pg];
+            victim = pg;
+        }
+    }
+    slot = page_tier2_slot[victim];
+    swap_queue(victim, tier2_slot_data(slot));
+    swap_flush();
+    page_tier2_slot[victim] = -1;
+    tier2_slot_page[slot] = -1;
+    tier2_evictions++;
+    return slot;
+}
+
+/* Move a resident page's contents into the slow tier */
+void tier2_demote(int page) {
+    int i, slot = -1;
+    for (i = 0; i < tier2_frames && slot == -1; i++) {
+        if (tier2_slot_page[i] == -1) slot = i;
+    }
+    if (slot == -1) slot = tier2_evict();
+    if (page_slot[page] >= 0) swap_free_slot(page);
+    memcpy(tier2_slot_data(slot), physical_memory[page_frame[page]], page_size_kb * 1024);
+    tier2_slot_page[slot] = page;
+    page_tier2_slot[page] = slot;
+    page_tier2_hits[page] = 0;
+    page_demoted_at[page] = lru_counter;
+    tier2_demotions++;
+}
+
+/* Open a new youngest generation and move every page referenced since the
+ * last walk into it */
+void mglru_age(void) {
+    int i, t;
+    mglru_max_seq++;
+    for (i = 0; i < total_frames; i++) {
+        int pg = frame_to_page[i];
+        if (!frame_occupied[i] || !ref_bit[pg]) continue;
+        ref_bit[pg] = 0;
+        frame_gen[i] = mglru_max_seq;
+        if (frame_tier[i] < MGLRU_TIERS - 1) frame_tier[i]++;
+        mglru_promotions++;
+    }
+    for (t = 0; t < MGLRU_TIERS; t++) {
+        tier_evicted[t] /= 2;
+        tier_refaulted[t] /= 2;
+    }
+    mglru_walks++;
+}
+
+int mglru_tier_protected(int tier) {
+    return tier > 0 &&
+           tier_refaulted[tier] * (tier_evicted[0] + 1) > tier_refaulted[0] * (tier_evicted[tier] + 1);
+}
+
+/* Evict from the oldest generation, starting after the last victim.  When
+ * it has nothing left to evict the next generation becomes the oldest. */
+int mglru_victim(void) {
+    int n, f, pg;
+    while (1) {
+        while (mglru_max_seq - mglru_min_seq < MGLRU_MIN_GENS) mglru_age();
+        for (n = 0; n < total_frames; n++) {
+            f = (clock_hand + n) % total_frames;
+            if (!frame_occupied[f] || !frame_on_list(f) || frame_gen[f] > mglru_min_seq) continue;
+            pg = frame_to_page[f];
+            if (ref_bit[pg]) {
+                ref_bit[pg] = 0;
+                frame_gen[f] = mglru_max_seq;
+                if (frame_tier[f] < MGLRU_TIERS - 1) frame_tier[f]++;
+                mglru_promotions++;
+            } else if (mglru_tier_protected(frame_tier[f])) {
+                frame_gen[f] = mglru_min_seq + 1;
+                frame_tier[f]--;
+                mglru_protected++;
+            } else {
+                clock_hand = (f + 1) % total_frames;
+                shadow_evicted[pg] = mglru_evictions++;
+                shadow_tier[pg] = frame_tier[f];
+                tier_evicted[frame_tier[f]] += 1.0;
+                return pg;
+            }
+        }
+        mglru_min_seq++;
+    }
+}
+
+/* A page enters the youngest generation; a refault restores the tier its
+ * shadow entry recorded */
+void mglru_add(int page, int frame) {
+    int tier = 0;
+    if (shadow_evicted[page] >= 0) {
+        if (mglru_evictions - shadow_evicted[page] < total_frames) {
+            tier = shadow_tier[page];
+            tier_refaulted[tier] += 1.0;
+            mglru_tier_refaults[tier]++;
+            mglru_refaults++;
+        }
+        shadow_evicted[page] = -1;
+    }
+    frame_gen[frame] = mglru_max_seq;
+    frame_tier[frame] = tier;
+}
+
+/* Choose the list to reclaim from: an empty list is never chosen,
+ * otherwise each list earns credit at its share of 200 per reclaim and the
+ * one further ahead is taken */
+int reclaim_list(void) {
+    int files = file_frames, anons = anon_frames, i;
+    
+    if (file_region_count == 0) return -1;
+    if (reclaim_proc >= 0) {
+        files = 0;
+        anons = 0;
+        for (i = 0; i < total_frames; i++) {
+            if (!frame_occupied[i] || page_proc(frame_to_page[i]) != reclaim_proc) continue;
+            if (page_file[frame_to_page[i]] > 0) files++;
+            else anons++;
+        }
+    }
+    if (files == 0) return 0;
+    if (anons == 0) return 1;
+    anon_scan_credit += swappiness;
+    file_scan_credit += 200 - swappiness;
+    if (file_scan_credit >= anon_scan_credit) {
+        file_scan_credit -= 200;
+        return 1;
+    }
+    anon_scan_credit -= 200;
+    return 0;
+}
+
+int pick_victim(void) {
+    reclaim_class = reclaim_list();
+    if (algo == 1) return lru_victim();
+    if (algo == 2) return clock_victim();
+    if (algo == 3) return aging_victim();
+    if (algo == 4) return mglru_victim();
+    if (algo == 5) return lecar_victim();
+    return dequeue();
+}
+
+/* Called with each victim before it is written out (used by the pager) */
+void (*evict_hook)(int page) = NULL;
+
+/* Demote victim to the slow tier (or queue it for swap when there is none,
+ * unless its swap copy is still current) and unmap it, along with every
+ * other process's mapping of a shared frame; returns its frame, still
+ * marked occupied.  Callers swap_flush() before reusing the frame. */
+int evict_page(int victim) {
+    int frame = page_frame[victim];
+    int p, q, to_swap = 0;
+    
+    if (evict_hook) evict_hook(victim);
+    if (page_slot[victim] >= 0) slot_frame[page_slot[victim]] = -1;
+    proc_frames[page_proc(victim)]--;
+    if (page_file[victim] > 0) {
+        file_frames--;
+        file_reclaims++;
+    } else {
+        anon_frames--;
+        anon_reclaims++;
+    }
+    
+    if (page_file[victim] > 0) {
+        if (!page_dirty[victim]) {
+            file_drops++;
+        } else if (physical_memory[frame]) {
+            file_io(victim, frame, 1);
+            file_writebacks++;
+        }
+    } else if (tier2_frames > 0 && physical_memory[frame]) tier2_demote(victim);
+    else if (!page_dirty[victim] && page_slot[victim] >= 0) {
+        swap_clean_drops++;
+        to_swap = 1;
+    } else if (physical_memory[frame]) {
+        swap_queue(victim, physical_memory[frame]);
+        swap_pending_procs[swap_pending - 1] = frame_procs[frame] & ~(1u << (victim / PROC_PAGES));
+        to_swap = 1;
+    }
+    if (frame_refcount[frame] > 1) {
+        /* The one slot (written now, or already current) serves every
+         * sharer; with private copies each would have written its own */
+        for (p = 0; p < MAX_PROCS; p++) {
+            q = p * PROC_PAGES + victim % PROC_PAGES;
+            if (q == victim || !(frame_procs[frame] & (1u << p))) continue;
+            page_valid[q] = 0;
+            resident_map[q >> 5] &= ~(1u << (q & 31));
+            page_frame[q] = -1;
+            if (to_swap) cow_swapouts_saved++;
+        }
+        shared_mappings -= frame_refcount[frame] - 1;
+    }
+    frame_refcount[frame] = 0;
+    frame_procs[frame] = 0;
+    page_valid[victim] = 0;
+    resident_map[victim >> 5] &= ~(1u << (victim & 31));
+    page_frame[victim] = -1;
+    frame_to_page[frame] = -1;
+    return frame;
+}
+
+void release_frame(int frame) {
+    frame_occupied[frame] = 0;
+    frame_vacant[frame] = 0xFFFF;
+    free_frame_count++;
+}
+
+/* Process to reclaim from when p faults with no frame to take: p itself
+ * at its limit, else the process furthest over its limit, else any */
+int pff_reclaim_proc(int p) {
+    int q, best = -1, excess = 0;
+    if (!pff_enabled) return -1;
+    if (proc_frames[p] >= rs_limit[p]) return p;
+    for (q = 0; q < nr_procs; q++) {
+        if (proc_frames[q] - rs_limit[q] > excess) {
+            excess = proc_frames[q] - rs_limit[q];
+            best = q;
+        }
+    }
+    return best;
+}
+
+/* Return a frame for page: a free one, or one reclaimed directly from a
+ * victim when none is free or (under PFF) the process is at its limit.
+ * With swap_batch > 1 the reclaim takes that many victims so their
+ * write-out is one contiguous batch; the extra frames go back on the free
+ * list. */
+int alloc_frame(int page) {
+    int p = page_proc(page);
+    int frame = -1, n;
+    
+    if (!pff_enabled || proc_frames[p] < rs_limit[p]) {
+        frame = numa_nodes > 1 ? numa_alloc_frame(page) : find_free_frame();
+    }
+    if (frame == -1) {
+        double start = get_time_ms(), skew = swap_model_skew_ms;
+        reclaim_proc = pff_reclaim_proc(p);
+        for (n = 1; n < swap_batch && n < total_frames; n++) {
+            if (reclaim_proc >= 0 && proc_frames[reclaim_proc] < 2) break;
+            release_frame(evict_page(pick_victim()));
+        }
+        frame = evict_page(pick_victim());
+        reclaim_proc = -1;
+        swap_flush();
+        direct_reclaims++;
+        direct_reclaim_ms += get_time_ms() - start + swap_model_skew_ms - skew;
+    }
+    return frame;
+}
+
+/* One kswapd slice: evict until the high watermark is free, then sleep */
+void kswapd_run(void) {
+    double start = get_time_ms(), skew = swap_model_skew_ms;
+    while (free_frame_count < kswapd_high_frames) {
+        release_frame(evict_page(pick_victim()));
+        kswapd_reclaims++;
+    }
+    swap_flush();
+    kswapd_ms += get_time_ms() - start + swap_model_skew_ms - skew;
+    kswapd_awake = 0;
+}
+
+/* Processes take turns issuing fork_quantum references each */
+int current_proc(void) {
+    int p, running = 0, k;
+    for (p = 0; p < nr_procs; p++) running += !proc_suspended[p];
+    k = (int)((lru_counter / fork_quantum) % running);
+    for (p = 0; proc_suspended[p] || k-- > 0; p++);
+    return p;
+}
+
+void frame_map_shared(int page, int frame) {
+    page_frame[page] = frame;
+    page_valid[page] = 1;
+    resident_map[page >> 5] |= 1u << (page & 31);
+    frame_refcount[frame]++;
+    frame_procs[frame] |= 1u << (page / PROC_PAGES);
+    if (++shared_mappings > shared_peak) shared_peak = shared_mappings;
+}
+
+/* Drop page's mapping of a frame other processes keep, handing the policy
+ * state to one of them when page owned it */
+void frame_unmap(int page) {
+    int frame = page_frame[page];
+    int p, q;
+    
+    page_valid[page] = 0;
+    resident_map[page >> 5] &= ~(1u << (page & 31));
+    page_frame[page] = -1;
+    frame_refcount[frame]--;
+    frame_procs[frame] &= ~(1u << (page / PROC_PAGES));
+    shared_mappings--;
+    if (frame_to_page[frame] != page) return;
+    
+    for (p = 0; !(frame_procs[frame] & (1u << p)); p++);
+    q = p * PROC_PAGES + page % PROC_PAGES;
+    frame_to_page[frame] = q;
+    proc_frames[page_proc(page)]--;
+    proc_frames[p]++;
+    lru_time[q] = lru_time[page];
+    ref_bit[q] = ref_bit[page];
+}
+
+/* The running process forks.  The child maps each of the parent's resident
+ * pages onto the same frame and shares each swapped-out page's slot; no
+ * memory is copied until someone writes. */
+void fork_process(void) {
+    int parent = current_proc(), child = nr_procs, v;
+    for (v = 0; v < PROC_PAGES; v++) {
+        int p = parent * PROC_PAGES + v, c = child * PROC_PAGES + v;
+        lru_time[c] = lru_time[p];
+        page_dirty[c] = page_dirty[p];
+        page_file[c] = page_file[p];
+        if (page_valid[p]) {
+            frame_map_shared(c, page_frame[p]);
+        } else if (page_slot[p] >= 0) {
+            page_slot[c] = page_slot[p];
+            page_on_disk[c] = 1;
+            slot_refs[page_slot[p]]++;
+        }
+    }
+    rs_limit[child] = rs_limit[parent] / 2 > pff_min_frames ? rs_limit[parent] / 2 : pff_min_frames;
+    nr_procs++;
+    forks_done++;
+}
+
+/* Give back p's pages until it owns at most limit frames */
+void pff_trim(int p, int limit) {
+    reclaim_proc = p;
+    while (proc_frames[p] > limit) {
+        release_frame(evict_page(pick_victim()));
+        pff_trims++;
+    }
+    reclaim_proc = -1;
+    swap_flush();
+}
+
+/* End of a PFF window: resize each running process's limit from its fault
+ * rate, then suspend or resume processes to fit the pool */
+void pff_tick(void) {
+    int p, running = 0, demand = 0, youngest = -1;
+    long refs, faults_all = 0, refs_all = 0;
+    double rate;
+    
+    for (p = 0; p < nr_procs; p++) {
+        if (proc_suspended[p]) {
+            pff_suspended_refs += pff_window;
+            continue;
+        }
+        refs = fork_active ? proc_refs[p] : pff_window;
+        rate = refs > 0 ? 1000.0 * proc_faults[p] / refs : 0.0;
+        if (refs == 0) {
+            /* Forked this window, nothing to judge yet */
+        } else if (rate > pff_upper && rs_limit[p] < total_frames) {
+            rs_limit[p] = rs_limit[p] + pff_step_frames < total_frames ? rs_limit[p] + pff_step_frames : total_frames;
+            pff_grows++;
+        } else if (rate < pff_lower && rs_limit[p] > pff_min_frames) {
+            rs_limit[p] = rs_limit[p] - pff_step_frames > pff_min_frames ? rs_limit[p] - pff_step_frames : pff_min_frames;
+            pff_shrinks++;
+            pff_trim(p, rs_limit[p]);
+        }
+        faults_all += proc_faults[p];
+        refs_all += refs;
+        proc_faults[p] = 0;
+        proc_refs[p] = 0;
+        demand += rs_limit[p];
+        running++;
+        youngest = p;
+    }
+    
+    if (demand > total_frames && running > 1 && refs_all > 0 && 1000.0 * faults_all / refs_all > pff_upper) {
+        pff_thrash_windows++;
+        proc_suspended[youngest] = 1;
+        pff_trim(youngest, 0);
+        pff_suspends++;
+        demand -= rs_limit[youngest];
+    } else {
+        for (p = 0; p < nr_procs; p++) {
+            if (proc_suspended[p] && demand + rs_limit[p] <= total_frames) {
+                proc_suspended[p] = 0;
+                pff_resumes++;
+                demand += rs_limit[p];
+            }
+        }
+    }
+    pff_limit_sum += demand;
+    pff_ticks++;
+    pff_next += pff_window;
+}
+
+/* Aging ticks, kswapd slices, forks and PFF windows fall due at set
+ * reference counts */
+void run_events(void) {
+    if (algo == 3 && lru_counter >= aging_next_tick) aging_tick();
+    if (kswapd_awake && lru_counter >= kswapd_next) kswapd_run();
+    while (fork_active && fork_next < fork_count && lru_counter >= fork_refs[fork_next]) {
+        if (nr_procs < MAX_PROCS) fork_process();
+        fork_next++;
+    }
+    if (pff_enabled && lru_counter >= pff_next) pff_tick();
+    update_next_event();
+}
+
+void kswapd_wake(void) {
+    if (kswapd_awake) return;
+    kswapd_awake = 1;
+    kswapd_wakeups++;
+    kswapd_next = (lru_counter / kswapd_interval + 1) * kswapd_interval;
+    update_next_event();
+}
+
+void install_page(int page, int frame) {
+    if (!frame_occupied[frame]) {
+        free_frame_count--;
+        if (kswapd_enabled && free_frame_count < kswapd_low_frames) kswapd_wake();
+    }
+    frame_vacant[frame] = 0;
+    page_frame[page] = frame;
+    page_valid[page] = 1;
+    resident_map[page >> 5] |= 1u << (page & 31);
+    frame_occupied[frame] = 1;
+    frame_to_page[frame] = page;
+    frame_refcount[frame] = 1;
+    frame_procs[frame] = 1u << (page / PROC_PAGES);
+    proc_frames[page_proc(page)]++;
+    if (page_file[page] > 0) file_frames++;
+    else anon_frames++;
+    frame_age[frame] = (unsigned short)(1u << (aging_bits - 1));
+    if (algo == 4) mglru_add(page, frame);
+    if (algo == 5) lecar_add(page, frame);
+    if (algo == 0) enqueue(page);
+}
+
+/* Serve a reference from the slow tier.  Pages are promoted back to a frame
+ * after tier2_promote_hits hits inside one sampling window, but never within
+ * tier2_cooldown references of their demotion so they cannot ping-pong. */
+void tier2_access(int page) {
+    int slot = page_tier2_slot[page];
+    long window = lru_counter / tier2_window;
+    char* data = tier2_slot_data(slot);
+    volatile char byte = data[0];
+    int frame;
+    
+    data[0] = byte;
+    tier2_hits++;
+    tier_access_ns += tier2_ns;
+    
+    if (page_tier2_window[page] != window) {
+        page_tier2_window[page] = window;
+        page_tier2_hits[page] = 0;
+    }
+    page_tier2_hits[page]++;
+    if (page_tier2_hits[page] < tier2_promote_hits ||
+        lru_counter - page_demoted_at[page] < tier2_cooldown) {
+        return;
+    }
+    
+    memcpy(tier2_scratch, data, page_size_kb * 1024);
+    tier2_slot_page[slot] = -1;
+    page_tier2_slot[page] = -1;
+    frame = alloc_frame(page);
+    if (physical_memory[frame]) {
+        memcpy(physical_memory[frame], tier2_scratch, page_size_kb * 1024);
+    }
+    install_page(page, frame);
+    page_dirty[page] = 1;
+    tier2_promotions++;
+}
+
+/* Give page a private copy of the frame it shares (copy-on-write fault) */
+void cow_fault(int page) {
+    double start = get_time_ms(), skew = swap_model_skew_ms;
+    long bytes = (long)page_size_kb * 1024;
+    int frame;
+    
+    if (physical_memory[page_frame[page]]) memcpy(cow_scratch, physical_memory[page_frame[page]], bytes);
+    frame = alloc_frame(page);
+    if (page_valid[page]) frame_unmap(page);
+    else if (page_slot[page] >= 0) swap_free_slot(page);  /* reclaim took the shared frame */
+    if (physical_memory[frame]) memcpy(physical_memory[frame], cow_scratch, bytes);
+    /* A private file mapping: the copy is the process's own and goes to
+     * swap, never back to the shared file */
+    if (page_file[page] > 0) page_file[page] = -page_file[page];
+    install_page(page, frame);
+    cow_faults++;
+    total_fault_time += get_time_ms() - start + swap_model_skew_ms - skew;
+}
+
+/* A write through a shared mapping copies the frame first.  A reference
+ * through a mapping that does not own the frame also counts as a
+ * reference for the owner's policy state. */
+void cow_access(int page, long ref) {
+    int owner;
+    if (ref_writes(page, ref)) {
+        if (frame_refcount[page_frame[page]] > 1) cow_fault(page);
+        page_dirty[page] = 1;
+        if (page_slot[page] >= 0) swap_free_slot(page);
+    }
+    owner = frame_to_page[page_frame[page]];
+    if (owner != page) {
+        lru_time[owner] = ref;
+        ref_bit[owner] = 1;
+    }
+}
+
+void handle_page_fault(int page) {
+    double fault_start = get_time_ms(), skew = swap_model_skew_ms;
+    int frame, slot = page_slot[page];
+    
+    proc_faults[page_proc(page)]++;
+    /* Another process already brought this shared slot back in */
+    if (slot >= 0 && slot_frame[slot] >= 0) {
+        frame_map_shared(page, slot_frame[slot]);
+        page_dirty[page] = 0;
+        cow_swapins_saved++;
+        total_fault_time += get_time_ms() - fault_start;
+        return;
+    }
+    
+    frame = alloc_frame(page);
+    if (page_file[page] > 0) {
+        file_io(page, frame, 0);
+        file_reads++;
+        page_dirty[page] = 0;
+    } else if (page_on_disk[page]) {
+        read_from_disk(page, frame);
+        page_dirty[page] = 0;
+        if (slot_refs[page_slot[page]] > 1) slot_frame[page_slot[page]] = frame;
+    } else {
+        if (physical_memory[frame]) {
+            memset(physical_memory[frame], page, page_size_kb * 1024);
+        }
+        page_dirty[page] = 1;
+    }
+    
+    install_page(page, frame);
+    
+    double fault_end = get_time_ms();
+    total_fault_time += (fault_end - fault_start) + swap_model_skew_ms - skew;
+}
+
+void access_page(int page) {
+    if (lru_counter >= next_event) run_events();
+    if (fork_active) {
+        page = current_proc() * PROC_PAGES + page % PROC_PAGES;
+        shared_sum += shared_mappings;
+        proc_refs[page / PROC_PAGES]++;
+    }
+    if (page_valid[page] == 0) {
+        if (tier2_frames > 0 && page_tier2_slot[page] >= 0) {
+            tier2_access(page);
+        } else {
+            page_faults++;
+            handle_page_fault(page);
+        }
     } else {
         int frame = page_frame[page];
         if (physical_memory[frame]) {
             volatile char data = physical_memory[frame][0];
             physical_memory[frame][0] = data;
         }
+        if (tier2_frames > 0) {
+            tier1_hits++;
+            tier_access_ns += tier1_ns;
+        }
+    }
+    if (numa_nodes > 1 && page_valid[page]) numa_account(page);
+    if (page_valid[page]) {
+        frame_ref[page_frame[page]] = 0xFFFF;
+        if (fork_active) cow_access(page, lru_counter);
+        else if (!page_dirty[page]) swap_write_page(page, lru_counter);
+        if (algo == 5) lecar_touch(page_frame[page], lru_counter);
     }
     lru_time[page] = lru_counter++;
     ref_bit[page] = 1;
 }
 
-long get_memory_kb(void) {
-    struct rusage usage;
-    getrusage(RUSAGE_CHILDREN, &usage);
-    return usage.ru_maxrss;
+#define ACCESS_BLOCK 32
+
+/* Residency bits of pages[j..n) ORed into miss */
+unsigned int miss_mask_scalar(int* pages, int n, int j, unsigned int miss) {
+    for (; j < n; j++) {
+        int pg = pages[j];
+        miss |= (((resident_map[pg >> 5] >> (pg & 31)) & 1u) ^ 1u) << j;
+    }
+    return miss;
 }
 
-int generate_trace_file(char* binary, char* trace_file) {
-   
-    return 0;
+#if defined(__x86_64__) || defined(__i386__)
+/* Eight pages per step: gather their bitmap words, shift each page's bit
+ * down and compare.  Compiled for AVX2 whatever the build flags are, and
+ * only called when the CPU has it. */
+__attribute__((target("avx2")))
+unsigned int miss_mask_avx2(int* pages, int n) {
+    unsigned int miss = 0;
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i pg = _mm256_loadu_si256((__m256i*)(pages + j));
+        __m256i word = _mm256_i32gather_epi32((int*)resident_map, _mm256_srli_epi32(pg, 5), 4);
+        __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(pg, _mm256_set1_epi32(31))),
+                                       _mm256_set1_epi32(1));
+        __m256i absent = _mm256_cmpeq_epi32(bit, _mm256_setzero_si256());
+        miss |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(absent)) << j;
+    }
+    return miss_mask_scalar(pages, n, j, miss);
 }
+#endif
 
-int* load_trace(char* trace_file, int* count) {
-    FILE* f = fopen(trace_file, "r");
-    char line[256];
-    int capacity = 10000;
-    int size = 0;
-    int* pages;
+/* Bit j set when pages[j] is not resident, for up to ACCESS_BLOCK pages */
+unsigned int miss_mask(int* pages, int n) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_avx2()) return miss_mask_avx2(pages, n);
+#endif
+    return miss_mask_scalar(pages, n, 0, 0);
+}
+
+/*
+ * Batched form of access_page.  Each block's hit/miss pattern comes from the
+ * residency bitmap; runs of hits are applied without branching on page_valid
+ * and only misses go through access_page.  The mask is recomputed after each
+ * miss because the fault may have evicted a later page of the block.  NUMA,
+ * slow-tier accounting and forked processes need per-reference work, so
+ * those configurations take the plain path.
+ */
+void access_pages(int* pages, int n) {
+    int i = 0;
+    
+    if (numa_nodes > 1 || tier2_frames > 0 || fork_active) {
+        for (i = 0; i < n; i++) access_page(pages[i]);
+        return;
+    }
     
-    if (!f) return NULL;
+    while (i < n) {
+        int m = n - i < ACCESS_BLOCK ? n - i : ACCESS_BLOCK;
+        unsigned int miss;
+        int hits, j;
+        
+        if (i + 2 * ACCESS_BLOCK <= n) {
+            for (j = ACCESS_BLOCK; j < 2 * ACCESS_BLOCK; j += 8) {
+                __builtin_prefetch(&page_frame[pages[i + j]]);
+                __builtin_prefetch(&lru_time[pages[i + j]], 1);
+            }
+        }
+        miss = miss_mask(pages + i, m);
+        hits = miss ? __builtin_ctz(miss) : m;
+        /* Stop the run at the next event; access_page() runs it */
+        if (hits > next_event - lru_counter) {
+            hits = (int)(next_event - lru_counter);
+        }
+        
+        for (j = 0; j < hits; j++) {
+            int pg = pages[i + j];
+            char* mem = physical_memory[page_frame[pg]];
+            if (mem) {
+                volatile char data = mem[0];
+                mem[0] = data;
+            }
+            frame_ref[page_frame[pg]] = 0xFFFF;
+            if (!page_dirty[pg]) swap_write_page(pg, lru_counter + j);
+            if (algo == 5) lecar_touch(page_frame[pg], lru_counter + j);
+            lru_time[pg] = lru_counter + j;
+            ref_bit[pg] = 1;
+        }
+        lru_counter += hits;
+        i += hits;
+        
+        if (hits < m) {
+            access_page(pages[i]);
+            i++;
+        }
+    }
+}
+
+long get_memory_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    return usage.ru_maxrss;
+}
+
+int generate_trace_file(char* binary, char* trace_file) {
+    (void)binary;
+    (void)trace_file;
+    return 0;
+}
+
+/* Open-addressing map from page to a small integer, with backward-shift delete */
+struct page_map {
+    int cap;
+    int count;
+    unsigned long* keys;
+    int* values;
+    char* used;
+};
+
+unsigned int page_hash(unsigned long page) {
+    unsigned long long h = page;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (unsigned int)h;
+}
+
+void page_map_init(struct page_map* m, int min_cap) {
+    m->cap = 16;
+    while (m->cap < min_cap * 2) m->cap *= 2;
+    m->count = 0;
+    m->keys = calloc(m->cap, sizeof(unsigned long));
+    m->values = calloc(m->cap, sizeof(int));
+    m->used = calloc(m->cap, 1);
+}
+
+void page_map_free(struct page_map* m) {
+    free(m->keys);
+    free(m->values);
+    free(m->used);
+}
+
+int page_map_slot(struct page_map* m, unsigned long page) {
+    int i = page_hash(page) & (m->cap - 1);
+    while (m->used[i] && m->keys[i] != page) i = (i + 1) & (m->cap - 1);
+    return i;
+}
+
+/* Returns the stored value or -1 */
+int page_map_get(struct page_map* m, unsigned long page) {
+    int i = page_map_slot(m, page);
+    return m->used[i] ? m->values[i] : -1;
+}
+
+void page_map_put(struct page_map* m, unsigned long page, int value) {
+    int i;
+    if ((m->count + 1) * 2 > m->cap) {
+        struct page_map bigger;
+        page_map_init(&bigger, m->cap);
+        for (i = 0; i < m->cap; i++) {
+            if (m->used[i]) page_map_put(&bigger, m->keys[i], m->values[i]);
+        }
+        page_map_free(m);
+        *m = bigger;
+    }
+    i = page_map_slot(m, page);
+    if (!m->used[i]) {
+        m->used[i] = 1;
+        m->keys[i] = page;
+        m->count++;
+    }
+    m->values[i] = value;
+}
+
+void page_map_del(struct page_map* m, unsigned long page) {
+    int i = page_map_slot(m, page), j;
+    if (!m->used[i]) return;
+    m->used[i] = 0;
+    m->count--;
+    for (j = (i + 1) & (m->cap - 1); m->used[j]; j = (j + 1) & (m->cap - 1)) {
+        int home = page_hash(m->keys[j]) & (m->cap - 1);
+        /* Move j back into the hole if its home is not in (i, j] */
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            m->used[i] = 1;
+            m->keys[i] = m->keys[j];
+            m->values[i] = m->values[j];
+            m->used[j] = 0;
+            i = j;
+        }
+    }
+}
+
+/*
+ * Parallel parser for valgrind lackey traces (" L 1ffefff8a0,8").
+ * The file is mmap'd and cut into one slice per thread at newline
+ * boundaries.  A first parallel pass counts each slice's lines, which
+ * bounds its records, so one array can be carved into per-slice ranges;
+ * the second pass decodes each slice straight into its range, and the
+ * ranges are then slid down over the gaps left by skipped lines.  The
+ * page numbers are finally renumbered densely in first-touch order, so
+ * distinct pages stay distinct at any page size as long as the trace
+ * touches no more than the 1024 pages the page tables hold.
+ */
+struct trace_slice {
+    const char* begin;
+    const char* end;
+    unsigned long page_bytes;
+    int page_shift;             /* >= 0 when page_bytes is a power of two */
+    unsigned long* pages;       /* this slice's range of the shared array */
+    long count;
+    long lines;
+};
+
+char trace_ops[8] = "L";        /* lackey record types that count as references;
+                                   "LSM" adds stores and modifies */
+int trace_threads = 0;          /* 0 = one per online CPU */
+int trace_pages_folded = 0;     /* warned that a trace has over 1024 pages */
+unsigned char hex_value[256];
+unsigned char op_wanted[256];
+
+void trace_tables_init(void) {
+    int c;
+    for (c = 0; c < 256; c++) {
+        hex_value[c] = 0xFF;
+        op_wanted[c] = strchr(trace_ops, c) != NULL && c != 0;
+    }
+    for (c = '0'; c <= '9'; c++) hex_value[c] = c - '0';
+    for (c = 'a'; c <= 'f'; c++) hex_value[c] = c - 'a' + 10;
+    for (c = 'A'; c <= 'F'; c++) hex_value[c] = c - 'A' + 10;
+}
+
+/* Length of the hex run at p (at most 16 digits), found 16 bytes at a time */
+int hex_run_length(const char* p, const char* end) {
+    int n = 0;
+#ifdef __SSE2__
+    if (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+        unsigned int bad = ~(unsigned int)_mm_movemask_epi8(_mm_or_si128(digit, alpha)) & 0xFFFF;
+        return bad ? __builtin_ctz(bad) : 16;
+    }
+#endif
+    while (p + n < end && n < 16 && hex_value[(unsigned char)p[n]] != 0xFF) n++;
+    return n;
+}
+
+void* count_trace_slice(void* arg) {
+    struct trace_slice* s = arg;
+    const char* p = s->begin;
+    const char* eol;
+
+    s->lines = 0;
+    while (p < s->end && (eol = memchr(p, '\n', s->end - p))) {
+        s->lines++;
+        p = eol + 1;
+    }
+    if (p < s->end) s->lines++;
+    return NULL;
+}
+
+void* parse_trace_slice(void* arg) {
+    struct trace_slice* s = arg;
+    const char* p = s->begin;
+
+    while (p < s->end) {
+        const char* eol = memchr(p, '\n', s->end - p);
+        const char* q;
+        unsigned long addr = 0;
+        int op, len, i;
+
+        if (!eol) eol = s->end;
+        /* " L addr,size" for data records, "I  addr,size" for fetches */
+        q = p + (*p == ' ');
+        if (q >= eol) {
+            p = eol + 1;
+            continue;
+        }
+        op = (unsigned char)*q;
+        q++;
+        while (q < eol && *q == ' ') q++;
+        len = hex_run_length(q, eol);
+        if (len > eol - q) len = (int)(eol - q);
+
+        if (op_wanted[op] && len > 0 && q + len < eol && q[len] == ',') {
+            for (i = 0; i < len; i++) {
+                addr = (addr << 4) | hex_value[(unsigned char)q[i]];
+            }
+            s->pages[s->count++] = s->page_shift >= 0 ? addr >> s->page_shift : addr / s->page_bytes;
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+/* Run fn over every slice, slice 0 on the calling thread */
+void run_trace_slices(void* (*fn)(void*), struct trace_slice* slices, pthread_t* threads, int n) {
+    int i;
+    for (i = 1; i < n; i++) {
+        if (pthread_create(&threads[i], NULL, fn, &slices[i]) != 0) {
+            fn(&slices[i]);
+            threads[i] = 0;
+        }
+    }
+    fn(&slices[0]);
+    for (i = 1; i < n; i++) {
+        if (threads[i]) pthread_join(threads[i], NULL);
+    }
+}
+
+int* parse_trace_text(char* trace_file, unsigned long page_bytes, long* count) {
+    struct trace_slice slices[64];
+    pthread_t threads[64];
+    struct page_map ids;
+    struct stat st;
+    char* map;
+    unsigned long* raw = NULL;
+    int* pages;
+    int* shrunk;
+    long total = 0, off = 0, lines = 0, j;
+    int fd, nthreads, i, id;
+
+    *count = 0;
+    fd = open(trace_file, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    trace_tables_init();
+
+    nthreads = trace_threads > 0 ? trace_threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > 64) nthreads = 64;
+    if (st.st_size < (1 << 20)) nthreads = 1;
+
+    for (i = 0; i < nthreads; i++) {
+        const char* begin = i == 0 ? map : slices[i - 1].end;
+        const char* end = map + st.st_size * (i + 1) / nthreads;
+        if (i == nthreads - 1) {
+            end = map + st.st_size;
+        } else if (end > begin) {
+            const char* nl = memchr(end - 1, '\n', map + st.st_size - (end - 1));
+            end = nl ? nl + 1 : map + st.st_size;
+        } else {
+            end = begin;
+        }
+        memset(&slices[i], 0, sizeof(slices[i]));
+        slices[i].begin = begin;
+        slices[i].end = end;
+        slices[i].page_bytes = page_bytes;
+        slices[i].page_shift = (page_bytes & (page_bytes - 1)) == 0 ? __builtin_ctzl(page_bytes) : -1;
+    }
+
+    run_trace_slices(count_trace_slice, slices, threads, nthreads);
+    for (i = 0; i < nthreads; i++) lines += slices[i].lines;
+    if (lines > 0) raw = malloc(lines * sizeof(unsigned long));
+    if (!raw) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    for (i = 0; i < nthreads; i++) {
+        slices[i].pages = raw + off;
+        off += slices[i].lines;
+    }
+    run_trace_slices(parse_trace_slice, slices, threads, nthreads);
+    munmap(map, st.st_size);
+
+    for (i = 0; i < nthreads; i++) {
+        memmove(raw + total, slices[i].pages, slices[i].count * sizeof(unsigned long));
+        total += slices[i].count;
+    }
+    if (total == 0) {
+        free(raw);
+        return NULL;
+    }
+
+    /* The ids are written over the front of the same buffer: id j lands in
+     * bytes already read as page number j / 2 */
+    pages = (int*)raw;
+    page_map_init(&ids, 1024);
+    for (j = 0; j < total; j++) {
+        id = page_map_get(&ids, raw[j]);
+        if (id < 0) {
+            id = ids.count;
+            page_map_put(&ids, raw[j], id);
+        }
+        pages[j] = id % 1024;
+    }
+    if (ids.count > 1024 && !trace_pages_folded) {
+        printf("\n  Warning: %s touches %d distinct pages; past 1024 they share page table entries\n",
+               trace_file, ids.count);
+        trace_pages_folded = 1;
+    }
+    page_map_free(&ids);
+    shrunk = realloc(pages, total * sizeof(int));
+    if (shrunk) pages = shrunk;
+    *count = total;
+    return pages;
+}
+
+int* load_trace(char* trace_file, long* count) {
+    return parse_trace_text(trace_file, (unsigned long)page_size_kb * 1024, count);
+}
+
+/*
+ * Synthetic workload generators.
+ *
+ * A workload is one pattern, or a "phase" mix that cycles through up to
+ * WL_MAX_PHASES patterns every phase_len references.  Generators are lazy:
+ * references are produced in batches on demand, so a stream of any length
+ * needs no more memory than one batch.  All randomness comes from splitmix64
+ * streams split off a single seed, so a (spec, seed) pair always yields the
+ * same references no matter which policy consumes them.
+ *
+ * Spec syntax:  name[:key=val,...]   or   phase:len=N/spec/spec/...
+ *   uniform                      every page equally likely
+ *   seq:rep=R                    sequential scan, each page touched R times
+ *   stride:k=K                   strided scan (default K = sqrt(span)); when K
+ *                                shares a factor with span, each pass starts
+ *                                one page later so every page is covered
+ *   stack:depth=D                push/pop random walk near a stack top
+ *   hotcold:hot=H,pct=P          P% of references to H hot pages
+ *   zipf:s=S                     Zipfian popularity with exponent S
+ * Every pattern also takes base=B and span=N to restrict it to pages
+ * [base, base + span) modulo the page count.
+ */
+#define WL_UNIFORM  0
+#define WL_SEQ      1
+#define WL_STRIDE   2
+#define WL_STACK    3
+#define WL_HOTCOLD  4
+#define WL_ZIPF     5
+
+#define WL_MAX_PHASES 8
+#define WL_BATCH 4096
+
+struct wl_pattern {
+    int type;
+    int base;
+    int span;
+    int repeat;
+    int stride;
+    int stride_pass;            /* steps per pass when gcd(stride, span) > 1, else 0 */
+    int depth;
+    int hot;
+    int hot_pct;
+    double skew;
+    double zipf_hx1;            /* rejection-inversion constants */
+    double zipf_hn;
+    double zipf_sp;
+    unsigned long long rng;
+    long step;
+    int top;
+};
+
+struct workload {
+    int num_pages;
+    long length;
+    long pos;
+    long phase_len;
+    int nphases;
+    struct wl_pattern phase[WL_MAX_PHASES];
+};
+
+char* wl_names[] = { "uniform", "seq", "stride", "stack", "hotcold", "zipf" };
+
+unsigned long long splitmix64(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Derive an independent stream seed; same (seed, stream) -> same result */
+unsigned long long wl_split(unsigned long long seed, unsigned long long stream) {
+    unsigned long long s = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    splitmix64(&s);
+    return splitmix64(&s);
+}
+
+unsigned long long hash_string(const char* str) {
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    while (*str) {
+        h ^= (unsigned char)*str++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* FNV-1a continued over n more bytes */
+unsigned long long hash_bytes(unsigned long long h, const char* buf, long n) {
+    long i;
+    for (i = 0; i < n; i++) {
+        h ^= (unsigned char)buf[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* Uniform integer in [0, n) without a division */
+int wl_below(unsigned long long* rng, int n) {
+    return (int)(((splitmix64(rng) >> 32) * (unsigned long long)n) >> 32);
+}
+
+double wl_unit(unsigned long long* rng) {
+    return (splitmix64(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Zipf sampling by rejection-inversion (Hormann & Derflinger), O(1) memory */
+double zipf_helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+double zipf_helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+double zipf_h(double s, double x) {
+    return exp(-s * log(x));
+}
+
+double zipf_hintegral(double s, double x) {
+    double lx = log(x);
+    return zipf_helper2((1.0 - s) * lx) * lx;
+}
+
+double zipf_hintegral_inv(double s, double x) {
+    double t = x * (1.0 - s);
+    if (t < -1.0) t = -1.0;
+    return exp(zipf_helper1(t) * x);
+}
+
+void zipf_setup(struct wl_pattern* p) {
+    double s = p->skew;
+    p->zipf_hx1 = zipf_hintegral(s, 1.5) - 1.0;
+    p->zipf_hn = zipf_hintegral(s, p->span + 0.5);
+    p->zipf_sp = 2.0 - zipf_hintegral_inv(s, zipf_hintegral(s, 2.5) - zipf_h(s, 2.0));
+}
+
+/* Returns a rank in [0, span); rank 0 is the most popular page */
+int zipf_sample(struct wl_pattern* p) {
+    double s = p->skew;
+    while (1) {
+        double u = p->zipf_hn + wl_unit(&p->rng) * (p->zipf_hx1 - p->zipf_hn);
+        double x = zipf_hintegral_inv(s, u);
+        long k = (long)(x + 0.5);
+        if (k < 1) k = 1;
+        else if (k > p->span) k = p->span;
+        if (k - x <= p->zipf_sp || u >= zipf_hintegral(s, k + 0.5) - zipf_h(s, (double)k)) {
+            return (int)(k - 1);
+        }
+    }
+}
+
+int wl_gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int wl_parse_pattern(char* spec, int num_pages, struct wl_pattern* p) {
+    char buf[256];
+    char* opts;
+    char* tok;
+    int i;
+
+    memset(p, 0, sizeof(*p));
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    opts = strchr(buf, ':');
+    if (opts) *opts++ = '\0';
+
+    p->type = -1;
+    for (i = 0; i < (int)(sizeof(wl_names) / sizeof(wl_names[0])); i++) {
+        if (strcmp(buf, wl_names[i]) == 0) p->type = i;
+    }
+    if (p->type < 0) return 0;
+
+    p->span = num_pages;
+    p->repeat = 1;
+    p->depth = 8;
+    p->hot_pct = 80;
+    p->skew = 0.99;
+
+    for (tok = opts ? strtok(opts, ",") : NULL; tok; tok = strtok(NULL, ",")) {
+        char* eq = strchr(tok, '=');
+        if (!eq) return 0;
+        *eq++ = '\0';
+        if (strcmp(tok, "base") == 0) p->base = atoi(eq);
+        else if (strcmp(tok, "span") == 0) p->span = atoi(eq);
+        else if (strcmp(tok, "rep") == 0) p->repeat = atoi(eq);
+        else if (strcmp(tok, "k") == 0) p->stride = atoi(eq);
+        else if (strcmp(tok, "depth") == 0) p->depth = atoi(eq);
+        else if (strcmp(tok, "hot") == 0) p->hot = atoi(eq);
+        else if (strcmp(tok, "pct") == 0) p->hot_pct = atoi(eq);
+        else if (strcmp(tok, "s") == 0) p->skew = atof(eq);
+        else return 0;
+    }
+
+    if (p->span <= 0 || p->span > num_pages) p->span = num_pages;
+    if (p->repeat < 1) p->repeat = 1;
+    if (p->stride <= 0) p->stride = (int)sqrt(p->span) > 1 ? (int)sqrt(p->span) : 1;
+    p->stride_pass = p->span / wl_gcd(p->stride, p->span);
+    if (p->stride_pass == p->span) p->stride_pass = 0;
+    if (p->depth < 1) p->depth = 1;
+    if (p->depth > p->span) p->depth = p->span;
+    if (p->hot <= 0) p->hot = p->span / 8 > 0 ? p->span / 8 : 1;
+    if (p->hot > p->span) p->hot = p->span;
+    if (p->skew <= 0.0) p->skew = 0.99;
+    if (p->type == WL_ZIPF) zipf_setup(p);
+    return 1;
+}
+
+int workload_init(struct workload* w, char* spec, int num_pages, long length, unsigned long long seed) {
+    char buf[256];
+    char* part;
+    char* save;
+    int i;
+
+    memset(w, 0, sizeof(*w));
+    w->num_pages = num_pages > 0 ? num_pages : 1;
+    w->length = length;
+
+    if (strncmp(spec, "phase", 5) != 0) {
+        if (!wl_parse_pattern(spec, w->num_pages, &w->phase[0])) return 0;
+        w->nphases = 1;
+    } else {
+        strncpy(buf, spec, sizeof(buf) - 1);
+        buf[sizeof(buf) - 1] = '\0';
+        part = strtok_r(buf, "/", &save);
+        w->phase_len = 1000;
+        if (strncmp(part, "phase:len=", 10) == 0) w->phase_len = atol(part + 10);
+        if (w->phase_len < 1) w->phase_len = 1;
+        while ((part = strtok_r(NULL, "/", &save)) && w->nphases < WL_MAX_PHASES) {
+            if (!wl_parse_pattern(part, w->num_pages, &w->phase[w->nphases])) return 0;
+            w->nphases++;
+        }
+        if (w->nphases == 0) return 0;
+    }
+
+    for (i = 0; i < w->nphases; i++) {
+        w->phase[i].rng = wl_split(seed, (unsigned long long)i + 1);
+    }
+    return 1;
+}
+
+void wl_fill_pattern(struct wl_pattern* p, int num_pages, int* out, int n) {
+    int i;
+    int base = p->base % num_pages;
+    int span = p->span;
+
+    switch (p->type) {
+    case WL_UNIFORM:
+        for (i = 0; i < n; i++) out[i] = wl_below(&p->rng, span);
+        break;
+    case WL_SEQ:
+        for (i = 0; i < n; i++) out[i] = (int)(((p->step + i) / p->repeat) % span);
+        break;
+    case WL_STRIDE:
+        for (i = 0; i < n; i++) {
+            long j = (p->step + i) / p->repeat;
+            out[i] = (int)((j * p->stride + (p->stride_pass ? j / p->stride_pass : 0)) % span);
+        }
+        break;
+    case WL_STACK:
+        for (i = 0; i < n; i++) {
+            unsigned long long r = splitmix64(&p->rng);
+            if ((r & 7) == 0 && p->top < p->depth - 1) p->top++;
+            else if ((r & 7) == 1 && p->top > 0) p->top--;
+            out[i] = span - 1 - p->top;
+        }
+        break;
+    case WL_HOTCOLD:
+        for (i = 0; i < n; i++) {
+            if (wl_below(&p->rng, 100) < p->hot_pct || p->hot == span) {
+                out[i] = wl_below(&p->rng, p->hot);
+            } else {
+                out[i] = p->hot + wl_below(&p->rng, span - p->hot);
+            }
+        }
+        break;
+    case WL_ZIPF:
+        for (i = 0; i < n; i++) out[i] = zipf_sample(p);
+        break;
+    }
+
+    for (i = 0; i < n; i++) {
+        out[i] = (out[i] + base) % num_pages;
+    }
+    p->step += n;
+}
+
+/* Produce up to max references; returns 0 once the workload is exhausted */
+int workload_fill(struct workload* w, int* out, int max) {
+    long left = w->length - w->pos;
+    int n = left < max ? (int)left : max;
+    int done = 0;
+
+    while (done < n) {
+        int idx = 0;
+        int chunk = n - done;
+        if (w->nphases > 1) {
+            long in_phase = w->phase_len - w->pos % w->phase_len;
+            idx = (int)((w->pos / w->phase_len) % w->nphases);
+            if (in_phase < chunk) chunk = (int)in_phase;
+        }
+        wl_fill_pattern(&w->phase[idx], w->num_pages, out + done, chunk);
+        done += chunk;
+        w->pos += chunk;
+    }
+    return n;
+}
+
+/* Default workload per test program, matched by substring of its name */
+struct {
+    char* match;
+    char* spec;
+} default_workloads[] = {
+    { "sequential", "seq:rep=8" },
+    { "random", "uniform" },
+    { "matrix", "phase:len=100/seq/stride" },
+    { "linked_list", "stride:k=7" },
+    { "recursion", "stack:depth=8" },
+    { "stack", "stack:depth=8" },
+    { "bubble", "hotcold:hot=6,pct=90" },
+    { "binary", "zipf:s=1.2" },
+    { "hash", "zipf:s=0.8" },
+    { "string", "phase:len=40/seq:rep=3/uniform" }
+};
+
+char* workload_spec_for(char* name) {
+    int i;
+    for (i = 0; i < workload_overrides; i++) {
+        if (strstr(name, workload_match[i])) return workload_spec[i];
+    }
+    for (i = 0; i < (int)(sizeof(default_workloads) / sizeof(default_workloads[0])); i++) {
+        if (strstr(name, default_workloads[i].match)) return default_workloads[i].spec;
+    }
+    return "hotcold:hot=4,pct=70";
+}
+
+/*
+ * Reference stream fed to the simulator: either a loaded trace or a lazy
+ * generator.  Every policy opens the same stream for a program, so they all
+ * see identical references.
+ */
+struct ref_stream {
+    int* trace;
+    int* counts;                /* repeat count per entry once run-length reduced */
+    long trace_size;            /* entries in trace */
+    long trace_refs;            /* references they stand for */
+    long pos;
+    int run_pos;                /* repeats of trace[pos] already returned */
+    int batch_max;              /* block size limit, 0 = WL_BATCH */
+    int borrowed;               /* trace belongs to shared_traces[] */
+    int use_workload;
+    struct workload wl;
+    int buf[WL_BATCH];
+    int counts_buf[WL_BATCH];
+};
+
+long stream_length(struct ref_stream* s) {
+    return s->use_workload ? s->wl.length : s->trace_refs;
+}
+
+/* Points *batch at the next block of references; returns its length */
+int stream_next(struct ref_stream* s, int** batch) {
+    int n = 0, max = s->batch_max > 0 ? s->batch_max : WL_BATCH;
+    if (s->use_workload) {
+        *batch = s->buf;
+        return workload_fill(&s->wl, s->buf, max);
+    }
+    if (s->counts) {
+        /* Expand runs back into individual references */
+        while (n < max && s->pos < s->trace_size) {
+            int left = s->counts[s->pos] - s->run_pos;
+            int take = left < max - n ? left : max - n;
+            int i;
+            for (i = 0; i < take; i++) s->buf[n++] = s->trace[s->pos];
+            s->run_pos += take;
+            if (s->run_pos == s->counts[s->pos]) {
+                s->pos++;
+                s->run_pos = 0;
+            }
+        }
+        *batch = s->buf;
+        return n;
+    }
+    n = s->trace_size - s->pos < max ? (int)(s->trace_size - s->pos) : max;
+    *batch = s->trace + s->pos;
+    s->pos += n;
+    return n;
+}
+
+/* Collapse immediate repeats in place; returns the number of runs */
+long rle_compress(int* pages, int* counts, long n) {
+    long i, runs = 0;
+    for (i = 0; i < n; i++) {
+        if (runs > 0 && pages[runs - 1] == pages[i] && counts[runs - 1] < 0x7FFFFFFF) {
+            counts[runs - 1]++;
+        } else {
+            pages[runs] = pages[i];
+            counts[runs] = 1;
+            runs++;
+        }
+    }
+    return runs;
+}
+
+/* Next block of (page, repeat count) runs; *refs gets the references
+ * covered.  A block of a run-length reduced trace may pass batch_max by the
+ * rest of its last run. */
+int stream_next_runs(struct ref_stream* s, int** pages, int** counts, long* refs) {
+    int n, i, max = s->batch_max > 0 ? s->batch_max : WL_BATCH;
+    *refs = 0;
+    if (s->counts) {
+        n = s->trace_size - s->pos < max ? (int)(s->trace_size - s->pos) : max;
+        *pages = s->trace + s->pos;
+        *counts = s->counts + s->pos;
+        s->pos += n;
+    } else {
+        n = stream_next(s, pages);
+        *refs = n;
+        if (*pages != s->buf) {
+            memcpy(s->buf, *pages, n * sizeof(int));
+            *pages = s->buf;
+        }
+        n = (int)rle_compress(s->buf, s->counts_buf, n);
+        *counts = s->counts_buf;
+        return n;
+    }
+    for (i = 0; i < n; i++) *refs += (*counts)[i];
+    return n;
+}
+
+/* Decoded traces held for several runs at one page size (the sweep) and
+ * lent read-only to every stream opened on the same binary */
+#define MAX_SHARED_TRACES 16
+
+struct shared_trace {
+    char binary[256];
+    int* trace;
+    int* counts;
+    long trace_size;
+    long trace_refs;
+};
+
+struct shared_trace shared_traces[MAX_SHARED_TRACES];
+int shared_trace_count = 0;
+
+struct shared_trace* find_shared_trace(char* binary) {
+    int i;
+    for (i = 0; i < shared_trace_count; i++) {
+        if (strcmp(shared_traces[i].binary, binary) == 0) return &shared_traces[i];
+    }
+    return NULL;
+}
+
+/* Open the reference stream for a program: its trace file when one
+ * exists, otherwise its synthetic workload.  The seed depends only on the
+ * program, so every consumer sees the same references. */
+struct ref_stream* open_stream(char* name, char* binary, int try_generate) {
+    char trace_file[512];
+    long trace_size = 0;
+    int num_pages = workload_pages > 0 ? workload_pages : total_frames * 3;
+    long accesses;
+    struct ref_stream* stream = calloc(1, sizeof(*stream));
+    struct shared_trace* shared = find_shared_trace(binary);
+    
+    if (!stream) return NULL;
+    if (num_pages > 1024) num_pages = 1024;
+    if (forks_supported() && num_pages > PROC_PAGES) {
+        if (!(fork_pages_folded & 1)) {
+            printf("\n  Warning: %d workload pages exceed the %d a process has with fork; capped\n",
+                   num_pages, PROC_PAGES);
+        }
+        fork_pages_folded |= 1;
+        num_pages = PROC_PAGES;
+    }
+    accesses = trace_length > 0 ? trace_length : (long)num_pages * 100;
+    if (shared) {
+        stream->trace = shared->trace;
+        stream->counts = shared->counts;
+        stream->trace_size = shared->trace_size;
+        stream->trace_refs = shared->trace_refs;
+        stream->borrowed = 1;
+        trace_size = shared->trace_refs;
+    } else {
+        snprintf(trace_file, sizeof(trace_file), "%s.trace", binary);
+        
+        /* Try to load existing trace first, then try valgrind */
+        stream->trace = load_trace(trace_file, &trace_size);
+        if ((!stream->trace || trace_size == 0) && try_generate) {
+            if (generate_trace_file(binary, trace_file)) {
+                stream->trace = load_trace(trace_file, &trace_size);
+            }
+        }
+        stream->trace_size = trace_size;
+        stream->trace_refs = trace_size;
+        
+        if (stream->trace && trace_size > 0 && trace_rle) {
+            stream->counts = malloc(trace_size * sizeof(int));
+            if (stream->counts) {
+                int* shrunk;
+                stream->trace_size = rle_compress(stream->trace, stream->counts, trace_size);
+                shrunk = realloc(stream->trace, stream->trace_size * sizeof(int));
+                if (shrunk) stream->trace = shrunk;
+                shrunk = realloc(stream->counts, stream->trace_size * sizeof(int));
+                if (shrunk) stream->counts = shrunk;
+            }
+        }
+    }
+    
+    if (stream->trace && trace_size > 0 && forks_supported() && !(fork_pages_folded & 2)) {
+        long i;
+        for (i = 0; i < stream->trace_size && stream->trace[i] < PROC_PAGES; i++);
+        if (i < stream->trace_size) {
+            printf("\n  Warning: %s's trace touches pages past %d; with fork they alias modulo %d\n",
+                   name, PROC_PAGES - 1, PROC_PAGES);
+            fork_pages_folded |= 2;
+        }
+    }
+    if (!stream->trace || trace_size == 0) {
+        char* spec = workload_spec_for(name);
+        if (!workload_init(&stream->wl, spec, num_pages, accesses,
+                           wl_split(workload_seed, hash_string(name)))) {
+            printf("\n  Warning: bad workload spec '%s', using uniform\n", spec);
+            workload_init(&stream->wl, "uniform", num_pages, accesses,
+                          wl_split(workload_seed, hash_string(name)));
+        }
+        stream->use_workload = 1;
+    }
+    return stream;
+}
+
+void close_stream(struct ref_stream* s) {
+    if (!s->borrowed) {
+        if (s->trace) free(s->trace);
+        if (s->counts) free(s->counts);
+    }
+    free(s);
+}
+
+/* Decode binary's trace once at the current page size and keep it in
+ * shared_traces[]; a binary without a trace is recorded as such so later
+ * opens go straight to its workload */
+void share_trace(char* name, char* binary) {
+    struct shared_trace* t;
+    struct ref_stream* s;
+    
+    if (find_shared_trace(binary) || shared_trace_count >= MAX_SHARED_TRACES) return;
+    s = open_stream(name, binary, 1);
+    if (!s) return;
+    t = &shared_traces[shared_trace_count++];
+    strncpy(t->binary, binary, sizeof(t->binary) - 1);
+    t->binary[sizeof(t->binary) - 1] = '\0';
+    t->trace = s->use_workload ? NULL : s->trace;
+    t->counts = s->use_workload ? NULL : s->counts;
+    t->trace_size = s->use_workload ? 0 : s->trace_size;
+    t->trace_refs = s->use_workload ? 0 : s->trace_refs;
+    if (!s->use_workload) s->borrowed = 1;
+    close_stream(s);
+}
+
+void release_shared_traces(void) {
+    int i;
+    for (i = 0; i < shared_trace_count; i++) {
+        free(shared_traces[i].trace);
+        free(shared_traces[i].counts);
+    }
+    shared_trace_count = 0;
+}
+
+/* Per-reference compute work, kept apart from the access loop */
+void simulate_work(long refs) {
+    long i;
+    int j, k;
+    volatile int dummy = 0;
+    
+    for (i = 0; i < refs; i++) {
+        for (j = 0; j < compute_work; j++) {
+            dummy = dummy + j;
+            for (k = 0; k < 10; k++) {
+                dummy = dummy * 2 / 2;
+            }
+        }
+    }
+}
+
+void simulate_fifo(int* trace, int trace_size) {
+    access_pages(trace, trace_size);
+    simulate_work(trace_size);
+}
+
+/*
+ * Checkpoints ("checkpoint_every <refs>" in config.txt).  At the first
+ * batch boundary past every checkpoint_every references the run's state
+ * is written to .vmm_ckpt/<result key>.ckpt: a header with the stream
+ * position and the swap areas' device state, the simulator globals listed
+ * below, the frames' contents, then each used swap slot and slow-tier slot
+ * with its contents.  A run whose key has a checkpoint resumes from it, so
+ * an interrupted replay loses at most one interval.  The file is mapped
+ * back in to restore it and removed once the run completes.  Time spent
+ * writing checkpoints is not charged to the run.
+ *
+ * The globals come in two lists: state that decides what the run does
+ * next, and counters that only report it.  A warm start (see warm_start())
+ * restores the state alone.
+ */
+#define CHECKPOINT_DIR ".vmm_ckpt"
+#define CKPT_MAGIC "VMMCKPT1"
+
+long checkpoint_every = 0;      /* references between checkpoints, 0 = off */
+long warmup_refs = 0;           /* references replayed once under LRU before each run, 0 = off */
+unsigned long long ckpt_key = 0;    /* key of the run being checkpointed, 0 = none */
+long ckpt_next = LONG_MAX;
+long sim_stop = LONG_MAX;       /* simulate_stream() returns at the first batch boundary past this */
+double sim_start_ms = 0.0;      /* start of the run's timed part */
+long sim_first_ref = 0;         /* lru_counter where the measured part began */
+int checkpoints_written = 0;
+int checkpoints_resumed = 0;
+
+struct ckpt_field {
+    void* addr;
+    long size;
+};
+
+#define CKPT_FIELD(x) { &(x), sizeof(x) }
+
+struct ckpt_field ckpt_state[] = {
+    CKPT_FIELD(page_frame), CKPT_FIELD(page_valid), CKPT_FIELD(page_on_disk),
+    CKPT_FIELD(resident_map), CKPT_FIELD(frame_occupied), CKPT_FIELD(frame_to_page),
+    CKPT_FIELD(fifo_next), CKPT_FIELD(fifo_prev), CKPT_FIELD(fifo_head), CKPT_FIELD(fifo_tail),
+    CKPT_FIELD(fifo_stamp), CKPT_FIELD(fifo_seq), CKPT_FIELD(page_file),
+    CKPT_FIELD(lru_time), CKPT_FIELD(lru_counter), CKPT_FIELD(clock_hand), CKPT_FIELD(ref_bit),
+    CKPT_FIELD(frame_age), CKPT_FIELD(frame_ref), CKPT_FIELD(frame_vacant), CKPT_FIELD(aging_next_tick),
+    CKPT_FIELD(mglru_max_seq), CKPT_FIELD(mglru_min_seq), CKPT_FIELD(frame_gen), CKPT_FIELD(frame_tier),
+    CKPT_FIELD(mglru_evictions), CKPT_FIELD(shadow_evicted), CKPT_FIELD(shadow_tier),
+    CKPT_FIELD(tier_evicted), CKPT_FIELD(tier_refaulted),
+    CKPT_FIELD(lecar_weight), CKPT_FIELD(lecar_rng), CKPT_FIELD(lecar_next), CKPT_FIELD(lecar_prev),
+    CKPT_FIELD(lecar_head), CKPT_FIELD(lecar_tail), CKPT_FIELD(lecar_heap), CKPT_FIELD(lecar_heap_pos),
+    CKPT_FIELD(lecar_heap_n), CKPT_FIELD(lecar_freq), CKPT_FIELD(lecar_stamp),
+    CKPT_FIELD(ghost_expert), CKPT_FIELD(ghost_seq), CKPT_FIELD(ghost_time), CKPT_FIELD(ghost_freq),
+    CKPT_FIELD(lecar_ghost_adds),
+    CKPT_FIELD(kswapd_awake), CKPT_FIELD(kswapd_next), CKPT_FIELD(free_frame_count),
+    CKPT_FIELD(fork_next), CKPT_FIELD(nr_procs), CKPT_FIELD(frame_refcount), CKPT_FIELD(frame_procs),
+    CKPT_FIELD(shared_mappings),
+    CKPT_FIELD(pff_next), CKPT_FIELD(rs_limit), CKPT_FIELD(proc_frames), CKPT_FIELD(proc_faults),
+    CKPT_FIELD(proc_refs), CKPT_FIELD(proc_suspended),
+    CKPT_FIELD(page_slot), CKPT_FIELD(page_dirty), CKPT_FIELD(slot_page), CKPT_FIELD(slot_refs),
+    CKPT_FIELD(slot_frame), CKPT_FIELD(cluster_used), CKPT_FIELD(swap_cur_cluster),
+    CKPT_FIELD(swap_next_slot), CKPT_FIELD(swap_last_area),
+    CKPT_FIELD(file_frames), CKPT_FIELD(anon_frames), CKPT_FIELD(anon_scan_credit), CKPT_FIELD(file_scan_credit),
+    CKPT_FIELD(page_hint_node), CKPT_FIELD(page_hint_count),
+    CKPT_FIELD(tier2_slot_page), CKPT_FIELD(page_tier2_slot), CKPT_FIELD(page_tier2_hits),
+    CKPT_FIELD(page_tier2_window), CKPT_FIELD(page_demoted_at), CKPT_FIELD(sim_first_ref),
+};
+
+struct ckpt_field ckpt_stats[] = {
+    CKPT_FIELD(page_faults), CKPT_FIELD(swaps), CKPT_FIELD(swap_ins), CKPT_FIELD(simulated_runs),
+    CKPT_FIELD(total_fault_time), CKPT_FIELD(total_swap_out_time), CKPT_FIELD(total_swap_in_time),
+    CKPT_FIELD(swap_model_skew_ms),
+    CKPT_FIELD(mglru_walks), CKPT_FIELD(mglru_promotions), CKPT_FIELD(mglru_protected),
+    CKPT_FIELD(mglru_refaults), CKPT_FIELD(mglru_tier_refaults),
+    CKPT_FIELD(lecar_evictions), CKPT_FIELD(lecar_ghost_hits), CKPT_FIELD(lecar_accounted),
+    CKPT_FIELD(lecar_phase_sum), CKPT_FIELD(lecar_phase_refs),
+    CKPT_FIELD(direct_reclaims), CKPT_FIELD(kswapd_reclaims), CKPT_FIELD(kswapd_wakeups),
+    CKPT_FIELD(direct_reclaim_ms), CKPT_FIELD(kswapd_ms),
+    CKPT_FIELD(forks_done), CKPT_FIELD(cow_faults), CKPT_FIELD(shared_peak), CKPT_FIELD(shared_sum),
+    CKPT_FIELD(cow_swapouts_saved), CKPT_FIELD(cow_swapins_saved),
+    CKPT_FIELD(pff_grows), CKPT_FIELD(pff_shrinks), CKPT_FIELD(pff_trims), CKPT_FIELD(pff_suspends),
+    CKPT_FIELD(pff_resumes), CKPT_FIELD(pff_thrash_windows), CKPT_FIELD(pff_ticks),
+    CKPT_FIELD(pff_limit_sum), CKPT_FIELD(pff_suspended_refs),
+    CKPT_FIELD(swap_write_calls), CKPT_FIELD(swap_clean_drops), CKPT_FIELD(swap_slot_frees),
+    CKPT_FIELD(swap_fallback_slots),
+    CKPT_FIELD(file_reads), CKPT_FIELD(file_writebacks), CKPT_FIELD(file_drops),
+    CKPT_FIELD(anon_reclaims), CKPT_FIELD(file_reclaims), CKPT_FIELD(file_io_time),
+    CKPT_FIELD(numa_accesses), CKPT_FIELD(numa_remote), CKPT_FIELD(numa_migrations), CKPT_FIELD(numa_access_ns),
+    CKPT_FIELD(tier1_hits), CKPT_FIELD(tier2_hits), CKPT_FIELD(tier2_promotions),
+    CKPT_FIELD(tier2_demotions), CKPT_FIELD(tier2_evictions), CKPT_FIELD(tier_access_ns),
+};
+
+#define CKPT_STATE_FIELDS (int)(sizeof(ckpt_state) / sizeof(ckpt_state[0]))
+#define CKPT_STATS_FIELDS (int)(sizeof(ckpt_stats) / sizeof(ckpt_stats[0]))
+
+/* Per swap area (the data file last): where it left off, and its I/O
+ * counters for this run */
+struct ckpt_area {
+    int next_cluster;
+    off_t dev_head;
+    unsigned long long rng;
+    struct swap_area_stats stats;
+};
+
+struct ckpt_header {
+    char magic[8];
+    unsigned long long key;
+    int frames;
+    int page_kb;
+    long state_bytes;           /* both field lists, to catch a layout change */
+    double elapsed_ms;
+    long stream_pos;
+    int stream_run_pos;
+    struct workload wl;
+    struct ckpt_area areas[MAX_SWAP_AREAS + 1];
+    int swap_slots;             /* used slots stored after the frames */
+    int tier2_slots;
+};
+
+long ckpt_state_bytes(void) {
+    long n = 0;
+    int i;
+    for (i = 0; i < CKPT_STATE_FIELDS; i++) n += ckpt_state[i].size;
+    for (i = 0; i < CKPT_STATS_FIELDS; i++) n += ckpt_stats[i].size;
+    return n;
+}
+
+void checkpoint_path(unsigned long long key, char* path, int size) {
+    snprintf(path, size, "%s/%016llx.ckpt", CHECKPOINT_DIR, key);
+}
+
+void ckpt_save_area(struct ckpt_area* c, struct swap_area* sa) {
+    c->next_cluster = sa->next_cluster;
+    c->dev_head = sa->dev_head;
+    c->rng = sa->rng;
+    c->stats = sa->stats;
+}
+
+/* Written to a temporary name and renamed, so a crash mid-write leaves the
+ * previous checkpoint in place */
+int checkpoint_write(struct ref_stream* s, unsigned long long key) {
+    struct ckpt_header h;
+    long bytes = (long)page_size_kb * 1024;
+    char path[64], tmp[80];
+    char* buf = calloc(1, bytes);
+    FILE* f;
+    int i, a, ok;
+    
+    if (!buf) return 0;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CKPT_MAGIC, 8);
+    h.key = key;
+    h.frames = total_frames;
+    h.page_kb = page_size_kb;
+    h.state_bytes = ckpt_state_bytes();
+    h.elapsed_ms = get_time_ms() - sim_start_ms;
+    h.stream_pos = s->pos;
+    h.stream_run_pos = s->run_pos;
+    h.wl = s->wl;
+    for (a = 0; a < swap_area_count; a++) ckpt_save_area(&h.areas[a], &swap_areas[a]);
+    ckpt_save_area(&h.areas[MAX_SWAP_AREAS], &file_backing);
+    for (i = 0; i < swap_total_slots; i++) h.swap_slots += slot_page[i] >= 0;
+    for (i = 0; i < tier2_frames; i++) h.tier2_slots += tier2_slot_page[i] >= 0;
+    
+    mkdir(CHECKPOINT_DIR, 0755);
+    checkpoint_path(key, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    f = fopen(tmp, "wb");
+    if (!f) {
+        free(buf);
+        return 0;
+    }
+    ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (i = 0; i < CKPT_STATE_FIELDS; i++) ok &= fwrite(ckpt_state[i].addr, ckpt_state[i].size, 1, f) == 1;
+    for (i = 0; i < CKPT_STATS_FIELDS; i++) ok &= fwrite(ckpt_stats[i].addr, ckpt_stats[i].size, 1, f) == 1;
+    for (i = 0; i < total_frames; i++) {
+        ok &= fwrite(physical_memory[i] ? physical_memory[i] : buf, bytes, 1, f) == 1;
+    }
+    for (i = 0; i < swap_total_slots; i++) {
+        if (slot_page[i] < 0) continue;
+        a = swap_area_of(i);
+        pread(fileno(swap_areas[a].file), buf, bytes, (off_t)(i - swap_areas[a].first_slot) * bytes);
+        ok &= fwrite(&i, sizeof(i), 1, f) == 1 && fwrite(buf, bytes, 1, f) == 1;
+    }
+    for (i = 0; i < tier2_frames; i++) {
+        if (tier2_slot_page[i] < 0) continue;
+        ok &= fwrite(&i, sizeof(i), 1, f) == 1 && fwrite(tier2_slot_data(i), bytes, 1, f) == 1;
+    }
+    free(buf);
+    if (ok && fclose(f) == 0) {
+        rename(tmp, path);
+        checkpoints_written++;
+        return 1;
+    }
+    unlink(tmp);
+    return 0;
+}
+
+/* Restore the checkpoint for key into a freshly initialised run and move
+ * the stream to where it was taken.  With warm set only the state list is
+ * restored; the counters stay at zero. */
+int checkpoint_read(struct ref_stream* s, unsigned long long key, int warm) {
+    struct ckpt_header* h;
+    struct stat st;
+    long bytes = (long)page_size_kb * 1024, need;
+    char path[64];
+    char* p;
+    void* map;
+    int fd, i, a, slot;
+    
+    checkpoint_path(key, path, sizeof(path));
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*h)) {
+        close(fd);
+        return 0;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    h = map;
+    need = sizeof(*h) + ckpt_state_bytes() + (long)total_frames * bytes +
+           ((long)h->swap_slots + h->tier2_slots) * (sizeof(int) + bytes);
+    if (memcmp(h->magic, CKPT_MAGIC, 8) != 0 || h->key != key || h->frames != total_frames ||
+        h->page_kb != page_size_kb || h->state_bytes != ckpt_state_bytes() || st.st_size != need) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+    
+    p = (char*)map + sizeof(*h);
+    for (i = 0; i < CKPT_STATE_FIELDS; i++) {
+        memcpy(ckpt_state[i].addr, p, ckpt_state[i].size);
+        p += ckpt_state[i].size;
+    }
+    for (i = 0; i < CKPT_STATS_FIELDS; i++) {
+        if (!warm) memcpy(ckpt_stats[i].addr, p, ckpt_stats[i].size);
+        p += ckpt_stats[i].size;
+    }
+    for (i = 0; i < total_frames; i++, p += bytes) {
+        if (physical_memory[i]) memcpy(physical_memory[i], p, bytes);
+    }
+    for (i = 0; i < h->swap_slots; i++, p += sizeof(int) + bytes) {
+        memcpy(&slot, p, sizeof(int));
+        a = swap_area_of(slot);
+        pwrite(fileno(swap_areas[a].file), p + sizeof(int), bytes, (off_t)(slot - swap_areas[a].first_slot) * bytes);
+    }
+    for (i = 0; i < h->tier2_slots; i++, p += sizeof(int) + bytes) {
+        memcpy(&slot, p, sizeof(int));
+        memcpy(tier2_slot_data(slot), p + sizeof(int), bytes);
+    }
+    for (a = 0; a <= MAX_SWAP_AREAS; a++) {
+        struct swap_area* sa = a < MAX_SWAP_AREAS ? &swap_areas[a] : &file_backing;
+        if (a < MAX_SWAP_AREAS && a >= swap_area_count) continue;
+        sa->next_cluster = h->areas[a].next_cluster;
+        sa->dev_head = h->areas[a].dev_head;
+        sa->rng = h->areas[a].rng;
+        if (!warm) sa->stats = h->areas[a].stats;
+    }
+    s->pos = h->stream_pos;
+    s->run_pos = h->stream_run_pos;
+    s->wl = h->wl;
+    sim_start_ms = get_time_ms() - (warm ? 0.0 : h->elapsed_ms);
+    munmap(map, st.st_size);
+    update_next_event();
+    return 1;
+}
+
+/* Counters back to zero after a warm-up replay */
+void ckpt_clear_stats(void) {
+    int i, a;
+    for (i = 0; i < CKPT_STATS_FIELDS; i++) memset(ckpt_stats[i].addr, 0, ckpt_stats[i].size);
+    for (a = 0; a < swap_area_count; a++) memset(&swap_areas[a].stats, 0, sizeof(swap_areas[a].stats));
+    memset(&file_backing.stats, 0, sizeof(file_backing.stats));
+}
+
+/* Seed the running policy's own structures from the recency state every
+ * policy keeps (lru_time, ref_bit), for state taken under another policy.
+ * FIFO queues the resident pages oldest first, MGLRU puts the referenced
+ * ones in the youngest generation, and LeCaR starts every count at zero. */
+void policy_adopt(void) {
+    int order[256], n = 0, i, j, f;
+    
+    for (f = 0; f < total_frames; f++) {
+        if (!frame_occupied[f]) continue;
+        for (i = n++; i > 0 && lru_time[frame_to_page[order[i - 1]]] > lru_time[frame_to_page[f]]; i--) {
+            order[i] = order[i - 1];
+        }
+        order[i] = f;
+    }
+    if (algo == 0) {
+        fifo_head[0] = fifo_head[1] = -1;
+        fifo_tail[0] = fifo_tail[1] = -1;
+        for (i = 0; i < n; i++) enqueue(frame_to_page[order[i]]);
+    } else if (algo == 3) {
+        aging_next_tick = lru_counter + aging_interval;
+    } else if (algo == 4) {
+        for (i = 0; i < n; i++) {
+            j = order[i];
+            frame_gen[j] = ref_bit[frame_to_page[j]] ? mglru_max_seq : mglru_min_seq;
+            frame_tier[j] = 0;
+        }
+    } else if (algo == 5) {
+        lecar_head = -1;
+        lecar_tail = -1;
+        lecar_heap_n = 0;
+        for (i = 0; i < n; i++) {
+            j = order[i];
+            lecar_freq[j] = 0;
+            lecar_stamp[j] = lru_time[frame_to_page[j]];
+            lecar_push_head(j);
+            lecar_heap_set(lecar_heap_n, j);
+            lecar_sift_up(lecar_heap_n++);
+        }
+    }
+    update_next_event();
+}
+
+/* Size the next block so it ends at the next checkpoint or stop */
+void stream_batch_limit(struct ref_stream* s) {
+    long left = (sim_stop < ckpt_next ? sim_stop : ckpt_next) - lru_counter;
+    s->batch_max = left >= WL_BATCH ? 0 : left > 0 ? (int)left : 1;
+}
+
+/* Called after every batch: take a checkpoint when one is due, and report
+ * whether the run should stop here */
+int stream_batch_done(struct ref_stream* s) {
+    if (ckpt_key && lru_counter >= ckpt_next) {
+        double start = get_time_ms();
+        checkpoint_write(s, ckpt_key);
+        ckpt_next = (lru_counter / checkpoint_every + 1) * checkpoint_every;
+        sim_start_ms += get_time_ms() - start;
+    }
+    stream_batch_limit(s);
+    live_publish();
+    return lru_counter >= sim_stop;
+}
+
+void simulate_stream(struct ref_stream* s) {
+    int* batch;
+    int* counts;
+    long refs;
+    int n;
+    
+    /* A repeat of the page just referenced is a hit that sets a ref_bit
+     * already set and bumps its LRU stamp, so a run costs one access.
+     * Stamps are only compared, and they stay monotonic once lru_counter
+     * skips the collapsed repeats, so FIFO/LRU/Clock decisions are
+     * unchanged.  NUMA and the slow tier account every reference,
+     * Aging and kswapd run at reference counts the collapsed repeats
+     * would skip, below 100% writes (write_percent or a file region's)
+     * each repeat may be the write that dirties the page, and forks hand
+     * the CPU to another process every fork_quantum references, and PFF
+     * windows close at reference counts too.  LeCaR's LFU expert counts
+     * every repeat. */
+    stream_batch_limit(s);
+    if (trace_rle && numa_nodes == 1 && tier2_frames == 0 && algo != 3 && algo != 5 && !kswapd_enabled &&
+        write_percent >= 100 && !fork_active && file_region_count == 0 && !pff_enabled) {
+        while ((n = stream_next_runs(s, &batch, &counts, &refs)) > 0) {
+            access_pages(batch, n);
+            lru_counter += refs - n;
+            simulated_runs += n;
+            simulate_work(refs);
+            if (stream_batch_done(s)) return;
+        }
+        return;
+    }
+    while ((n = stream_next(s, &batch)) > 0) {
+        simulated_runs += n;
+        simulate_fifo(batch, n);
+        if (stream_batch_done(s)) return;
+    }
+}
+
+/*
+ * Real-kernel baseline: run the compiled program with its memory capped.
+ * The cap is a transient cgroup v2 memory.max of the configured size plus
+ * the C runtime's baseline, made under linux_cgroup or our own cgroup.
+ * When that parent offers the memory controller but has not enabled it
+ * for its children, +memory is written to its cgroup.subtree_control for
+ * the run and taken back afterwards.  Otherwise the cap is an RLIMIT_AS
+ * set in the child before exec, sized to the simulated footprint plus the
+ * runtime's baseline.  An address-space cap covers malloc's mmap()ed
+ * chunks as well as brk, but it only stops the program from growing past
+ * the footprint; it cannot make the kernel reclaim, so rlimit runs show
+ * no memory pressure.  They are reported as unconstrained and left out of
+ * the comparison with the policies.  Each run records which mode it used
+ * and why.
+ */
+#define LIMIT_NONE   0
+#define LIMIT_CGROUP 1
+#define LIMIT_RLIMIT 2
+
+long linux_limit_kb = 0;        /* 0 = mem_size_kb */
+long linux_baseline_kb = 8192;  /* ld.so, libc, stack and malloc arena of a test program */
+char linux_cgroup[256] = "";    /* delegated cgroup directory, "" = our own cgroup */
+int linux_runs = 0;
+char linux_enabled_memory[1200] = "";   /* subtree_control we wrote +memory to */
+
+/* 1 if the whitespace-separated list in path contains word */
+int file_has_word(char* path, char* word) {
+    FILE* f = fopen(path, "r");
+    char token[64];
+    int found = 0;
+    if (!f) return 0;
+    while (!found && fscanf(f, "%63s", token) == 1) {
+        found = strcmp(token, word) == 0;
+    }
+    fclose(f);
+    return found;
+}
+
+int write_file(char* path, char* text) {
+    int fd = open(path, O_WRONLY);
+    int ok;
+    if (fd < 0) return 0;
+    ok = write(fd, text, strlen(text)) == (ssize_t)strlen(text);
+    close(fd);
+    return ok;
+}
+
+/* Value of "key N" in a flat-keyed file such as memory.stat, or -1 */
+long read_key_value(char* path, char* key) {
+    FILE* f = fopen(path, "r");
+    char name[128];
+    long value, result = -1;
+    if (!f) return -1;
+    while (fscanf(f, "%127s %ld", name, &value) == 2) {
+        if (strcmp(name, key) == 0) {
+            result = value;
+            break;
+        }
+    }
+    fclose(f);
+    return result;
+}
+
+/* Directory of our own cgroup: <cgroup2 mount><path in /proc/self/cgroup> */
+int cgroup_self(char* dir, size_t len) {
+    FILE* f;
+    char line[1024], mount[512] = "", self[512] = "";
+
+    f = fopen("/proc/self/mountinfo", "r");
+    if (!f) return 0;
+    while (fgets(line, sizeof(line), f)) {
+        char mnt[512];
+        if (strstr(line, " - cgroup2 ") && sscanf(line, "%*s %*s %*s %*s %511s", mnt) == 1) {
+            strcpy(mount, mnt);
+            break;
+        }
+    }
+    fclose(f);
+    f = fopen("/proc/self/cgroup", "r");
+    if (!f) return 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "0::", 3) == 0) {
+            sscanf(line + 3, "%511s", self);
+        }
+    }
+    fclose(f);
+    if (!mount[0] || !self[0]) return 0;
+    if (strcmp(self, "/") == 0) self[0] = '\0';
+    snprintf(dir, len, "%s%s", mount, self);
+    return 1;
+}
+
+/* Take back a +memory that cgroup_create wrote */
+void cgroup_restore(void) {
+    if (!linux_enabled_memory[0]) return;
+    write_file(linux_enabled_memory, "-memory");
+    linux_enabled_memory[0] = '\0';
+}
+
+/* Create <delegated cgroup>/vmm-<pid>-<n> with memory.max set; on failure
+ * why says what was missing */
+int cgroup_create(char* dir, size_t len, long limit_bytes, char* why, size_t why_len) {
+    char parent[1100], path[1200], controllers[1200], value[32];
+
+    if (linux_cgroup[0]) {
+        snprintf(parent, sizeof(parent), "%s", linux_cgroup);
+    } else if (!cgroup_self(parent, sizeof(parent))) {
+        snprintf(why, why_len, "no cgroup2 hierarchy");
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s/cgroup.subtree_control", parent);
+    if (!file_has_word(path, "memory")) {
+        /* Refused with EBUSY while the parent holds processes itself, as
+           our own cgroup does unless it is the root */
+        snprintf(controllers, sizeof(controllers), "%s/cgroup.controllers", parent);
+        if (!file_has_word(controllers, "memory") || !write_file(path, "+memory")) {
+            snprintf(why, why_len, "memory controller not delegated to %.60s", parent);
+            return 0;
+        }
+        strcpy(linux_enabled_memory, path);
+    }
+    snprintf(dir, len, "%s/vmm-%d-%d", parent, (int)getpid(), linux_runs);
+    if (mkdir(dir, 0755) != 0) {
+        snprintf(why, why_len, "cannot create a cgroup in %.50s: %s", parent, strerror(errno));
+        cgroup_restore();
+        return 0;
+    }
+
+    snprintf(path, sizeof(path), "%s/memory.max", dir);
+    snprintf(value, sizeof(value), "%ld", limit_bytes);
+    if (!write_file(path, value)) {
+        snprintf(why, why_len, "memory.max not writable in %.60s", parent);
+        rmdir(dir);
+        cgroup_restore();
+        return 0;
+    }
+    if (linux_enabled_memory[0]) snprintf(why, why_len, "cgroup %.60s, +memory for the run", parent);
+    else snprintf(why, why_len, "delegated cgroup %.70s", parent);
+    return 1;
+}
+
+/* minflt and majflt from /proc/<pid>/stat (fields 10 and 12) */
+int read_proc_faults(pid_t pid, long* minflt, long* majflt) {
+    char path[64], buf[1024];
+    char* p;
+    FILE* f;
+    size_t n;
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    f = fopen(path, "r");
+    if (!f) return 0;
+    n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    p = strrchr(buf, ')');
+    if (!p) return 0;
+    return sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %ld %*d %ld", minflt, majflt) == 2;
+}
+
+void run_on_linux(char* program, struct program_info* info) {
+    double start, end;
+    char cgroup_dir[1200], path[1300], go = 1;
+    long limit_kb = (linux_limit_kb > 0 ? linux_limit_kb : mem_size_kb) + linux_baseline_kb;
+    int num_pages = workload_pages > 0 ? workload_pages : total_frames * 3;
+    long minflt = 0, majflt = 0;
+    int sync_pipe[2];
+    int status = 0;
+    struct rusage usage;
+    siginfo_t si;
+    pid_t pid;
+
+    info->memory_kb = mem_size_kb;  /* Use configured memory */
+    info->linux_limit_mode = LIMIT_NONE;
+    info->linux_status = -1;
+    info->linux_limit_used_kb = 0;
+    strcpy(info->linux_limit_why, "not run");
+    if (access(program, X_OK) != 0 || pipe(sync_pipe) != 0) return;
+
+    linux_runs++;
+    if (cgroup_create(cgroup_dir, sizeof(cgroup_dir), limit_kb * 1024,
+                      info->linux_limit_why, sizeof(info->linux_limit_why))) {
+        info->linux_limit_mode = LIMIT_CGROUP;
+    } else {
+        /* The address space has to hold the whole footprint */
+        if (num_pages > 1024) num_pages = 1024;
+        limit_kb = (long)num_pages * page_size_kb + linux_baseline_kb;
+        info->linux_limit_mode = LIMIT_RLIMIT;
+    }
+    info->linux_limit_used_kb = limit_kb;
+
+    start = get_time_ms();
+    pid = fork();
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        close(sync_pipe[1]);
+        if (read(sync_pipe[0], &go, 1) != 1) _exit(126);
+        if (devnull >= 0) {
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+        }
+        if (info->linux_limit_mode == LIMIT_RLIMIT) {
+            struct rlimit rl;
+            rl.rlim_cur = rl.rlim_max = (rlim_t)limit_kb * 1024;
+            setrlimit(RLIMIT_AS, &rl);
+        }
+        execl(program, program, (char*)NULL);
+        _exit(127);
+    }
+    close(sync_pipe[0]);
+    if (pid < 0) {
+        close(sync_pipe[1]);
+        if (info->linux_limit_mode == LIMIT_CGROUP) {
+            rmdir(cgroup_dir);
+            cgroup_restore();
+        }
+        return;
+    }
+    if (info->linux_limit_mode == LIMIT_CGROUP) {
+        char pid_text[32];
+        snprintf(path, sizeof(path), "%s/cgroup.procs", cgroup_dir);
+        snprintf(pid_text, sizeof(pid_text), "%d", (int)pid);
+        write_file(path, pid_text);
+    }
+    write(sync_pipe[1], &go, 1);
+    close(sync_pipe[1]);
+
+    /* Read the zombie's counters before reaping it */
+    if (waitid(P_PID, pid, &si, WEXITED | WNOWAIT) == 0) {
+        read_proc_faults(pid, &minflt, &majflt);
+    }
+    wait4(pid, &status, 0, &usage);
+    end = get_time_ms();
+
+    info->linux_time = end - start;
+    info->linux_minor_faults = minflt > 0 ? minflt : usage.ru_minflt;
+    info->linux_major_faults = majflt > 0 ? majflt : usage.ru_majflt;
+    info->linux_status = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+    info->linux_swap_in = 0;
+    info->linux_swap_out = 0;
+
+    if (info->linux_limit_mode == LIMIT_CGROUP) {
+        long v;
+        snprintf(path, sizeof(path), "%s/memory.stat", cgroup_dir);
+        if ((v = read_key_value(path, "pswpin")) > 0) info->linux_swap_in = v;
+        if ((v = read_key_value(path, "pswpout")) > 0) info->linux_swap_out = v;
+        snprintf(path, sizeof(path), "%s/memory.events", cgroup_dir);
+        if (read_key_value(path, "oom_kill") > 0) info->linux_status = -SIGKILL;
+        rmdir(cgroup_dir);
+        cgroup_restore();
+    }
+}
+
+/*
+ * Userspace pager: each test program is rebuilt as a shared object whose
+ * malloc/free resolve to the pager_* allocator below, then run in a child
+ * whose heap lives in a userfaultfd-registered region.  A pager thread in
+ * the child serves the missing-page faults with the simulator's own frame
+ * table, victim functions and disk_swap.bin, so FIFO/LRU/Clock are timed
+ * on the real program.  The program is single threaded and stays blocked
+ * on its fault while the pager works, so the region can be edited safely.
+ *
+ * Hardware reference bits are not visible from userspace.  For LRU and
+ * Clock the pager drops resident pages from the region every
+ * pager_scan_faults faults (keeping their data in the frame buffer); the
+ * next touch takes a cheap hinting fault that sets ref_bit and lru_time.
+ */
+int pager_enabled = 0;
+int pager_scan_faults = 0;      /* 0 = total_frames */
+
+char* pager_region = NULL;
+unsigned long pager_page_bytes = 0;
+unsigned long pager_brk = 0;
+int pager_uffd = -1;
+int pager_hinted[1024];
+int pager_faults_since_scan = 0;
+long pager_minor_faults = 0;
+
+struct pager_result {
+    double time;
+    long faults;
+    long minor_faults;
+    long swaps;
+    int status;
+};
+
+/* Bump allocator over the region; freeing the newest block rolls it back */
+void* pager_malloc(size_t size) {
+    unsigned long need = (sizeof(size_t) + size + 15) & ~15UL;
+    char* block;
+    if (!pager_region || pager_brk + need > pager_page_bytes * 1024) return NULL;
+    block = pager_region + pager_brk;
+    *(size_t*)block = need;
+    pager_brk += need;
+    return block + sizeof(size_t);
+}
+
+void pager_free(void* ptr) {
+    char* block;
+    if (!ptr) return;
+    block = (char*)ptr - sizeof(size_t);
+    if (block + *(size_t*)block == pager_region + pager_brk) {
+        pager_brk = block - pager_region;
+    }
+}
+
+void* pager_calloc(size_t n, size_t size) {
+    void* ptr = pager_malloc(n * size);
+    if (ptr) memset(ptr, 0, n * size);
+    return ptr;
+}
+
+void* pager_realloc(void* ptr, size_t size) {
+    void* fresh = pager_malloc(size);
+    if (ptr && fresh) {
+        size_t old = *(size_t*)((char*)ptr - sizeof(size_t)) - sizeof(size_t);
+        memcpy(fresh, ptr, old < size ? old : size);
+        pager_free(ptr);
+    }
+    return fresh;
+}
+
+char* pager_page_addr(int page) {
+    return pager_region + (unsigned long)page * pager_page_bytes;
+}
+
+void pager_copy_in(int page, char* src) {
+    struct uffdio_copy copy;
+    copy.dst = (unsigned long)pager_page_addr(page);
+    copy.src = (unsigned long)src;
+    copy.len = pager_page_bytes;
+    copy.mode = 0;
+    copy.copy = 0;
+    ioctl(pager_uffd, UFFDIO_COPY, &copy);
+}
+
+/* Move a page's live contents into its frame buffer and unmap it */
+void pager_save(int page) {
+    if (!pager_hinted[page]) {
+        memcpy(physical_memory[page_frame[page]], pager_page_addr(page), pager_page_bytes);
+    }
+    madvise(pager_page_addr(page), pager_page_bytes, MADV_DONTNEED);
+}
+
+/* alloc_frame() hook: the victim is written to swap from its frame buffer */
+void pager_evict(int page) {
+    pager_save(page);
+    pager_hinted[page] = 0;
+}
+
+void pager_scan(int except) {
+    int i;
+    for (i = 0; i < total_frames; i++) {
+        int pg = frame_to_page[i];
+        if (frame_occupied[i] && pg >= 0 && pg != except && !pager_hinted[pg]) {
+            pager_save(pg);
+            pager_hinted[pg] = 1;
+            ref_bit[pg] = 0;
+        }
+    }
+}
+
+void pager_fault(int page) {
+    int frame;
+    
+    if (page_valid[page]) {
+        /* Hinting fault: resident, only unmapped to sample its reference */
+        pager_minor_faults++;
+        pager_hinted[page] = 0;
+        pager_copy_in(page, physical_memory[page_frame[page]]);
+        lru_time[page] = lru_counter++;
+        ref_bit[page] = 1;
+        return;
+    }
+    
+    if (tier2_frames > 0 && page_tier2_slot[page] >= 0) {
+        /* Demoted: the program can only touch it mapped, so promote it.
+         * Copy it out first, since alloc_frame() may need the slot. */
+        int slot = page_tier2_slot[page];
+        pager_minor_faults++;
+        tier2_hits++;
+        tier2_promotions++;
+        memcpy(tier2_scratch, tier2_slot_data(slot), pager_page_bytes);
+        tier2_slot_page[slot] = -1;
+        page_tier2_slot[page] = -1;
+        frame = alloc_frame(page);
+        memcpy(physical_memory[frame], tier2_scratch, pager_page_bytes);
+    } else {
+        page_faults++;
+        frame = alloc_frame(page);
+        if (page_on_disk[page]) {
+            read_from_disk(page, frame);
+            swap_free_slot(page);   /* the program may write it; no way to tell */
+        } else {
+            memset(physical_memory[frame], 0, pager_page_bytes);
+        }
+    }
+    page_dirty[page] = 1;
+    install_page(page, frame);
+    lru_time[page] = lru_counter++;
+    ref_bit[page] = 1;
+    
+    if (algo != 0 && ++pager_faults_since_scan >= pager_scan_faults) {
+        pager_scan(page);
+        pager_faults_since_scan = 0;
+    }
+    pager_copy_in(page, physical_memory[frame]);
+}
+
+void* pager_thread(void* arg) {
+    struct uffd_msg msg;
+    (void)arg;
+    while (read(pager_uffd, &msg, sizeof(msg)) == sizeof(msg)) {
+        if (msg.event == UFFD_EVENT_PAGEFAULT) {
+            unsigned long off = msg.arg.pagefault.address - (unsigned long)pager_region;
+            pager_fault((int)(off / pager_page_bytes));
+        }
+    }
+    return NULL;
+}
+
+/* Child side: set up the region and pager, then run the program's main */
+void pager_child(char* object, int algorithm, int out_fd) {
+    struct pager_result res;
+    struct uffdio_api api;
+    struct uffdio_register reg;
+    pthread_t thread;
+    void* handle;
+    int (*prog_main)(void);
+    double start;
+    int i, devnull;
+    
+    memset(&res, 0, sizeof(res));
+    res.status = -1;
+    algo = algorithm;
+    file_region_count = 0;      /* the program's own memory is all anonymous */
+    init_memory();
+    for (i = 0; i < 1024; i++) pager_hinted[i] = 0;
+    pager_page_bytes = (unsigned long)page_size_kb * 1024;
+    if (pager_scan_faults <= 0) pager_scan_faults = total_frames;
+    evict_hook = pager_evict;
+    
+    pager_region = mmap(NULL, pager_page_bytes * 1024, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    /* User-mode-only faults need no privilege under
+       vm.unprivileged_userfaultfd=0; kernels before 5.11 reject the flag */
+    pager_uffd = syscall(SYS_userfaultfd, O_CLOEXEC | UFFD_USER_MODE_ONLY);
+    if (pager_uffd < 0 && errno == EINVAL)
+        pager_uffd = syscall(SYS_userfaultfd, O_CLOEXEC);
+    memset(&api, 0, sizeof(api));
+    api.api = UFFD_API;
+    memset(&reg, 0, sizeof(reg));
+    reg.range.start = (unsigned long)pager_region;
+    reg.range.len = pager_page_bytes * 1024;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if (pager_region == MAP_FAILED || pager_uffd < 0 ||
+        ioctl(pager_uffd, UFFDIO_API, &api) != 0 ||
+        ioctl(pager_uffd, UFFDIO_REGISTER, &reg) != 0 ||
+        pthread_create(&thread, NULL, pager_thread, NULL) != 0) {
+        write(out_fd, &res, sizeof(res));
+        _exit(1);
+    }
+    
+    /* The program's output would land in the report, as for the Linux baseline */
+    devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+    handle = dlopen(object, RTLD_NOW);
+    prog_main = handle ? (int (*)(void))dlsym(handle, "pager_main") : NULL;
+    if (prog_main) {
+        start = get_time_ms();
+        res.status = prog_main();
+        res.time = get_time_ms() - start + swap_model_skew_ms;
+    }
+    res.faults = page_faults;
+    res.minor_faults = pager_minor_faults;
+    res.swaps = swaps;
+    write(out_fd, &res, sizeof(res));
+    _exit(0);
+}
+
+void run_pager(char* object, struct program_info* info) {
+    int algorithm;
+    
+    info->pager_ok = 0;
+    if (((unsigned long)page_size_kb * 1024) % sysconf(_SC_PAGESIZE) != 0) return;
+    
+    for (algorithm = 0; algorithm < 3; algorithm++) {
+        struct pager_result res;
+        int fds[2];
+        pid_t pid;
+        
+        if (pipe(fds) != 0) return;
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            pager_child(object, algorithm, fds[1]);
+        }
+        close(fds[1]);
+        memset(&res, 0, sizeof(res));
+        res.status = -1;
+        if (pid > 0) {
+            if (read(fds[0], &res, sizeof(res)) != sizeof(res)) res.status = -1;
+            waitpid(pid, NULL, 0);
+        }
+        close(fds[0]);
+        if (res.status != 0) return;
+        
+        info->pager_time[algorithm] = res.time;
+        info->pager_faults[algorithm] = res.faults;
+        info->pager_minor_faults[algorithm] = res.minor_faults;
+        info->pager_swaps[algorithm] = res.swaps;
+    }
+    info->pager_ok = 1;
+}
+
+/*
+ * Sampled miss-ratio curves (SHARDS).  A page is sampled when a hash of its
+ * number falls below a threshold T out of 2^24, i.e. with rate R = T/2^24,
+ * so every reference to a sampled page is seen.  LRU stack distances among
+ * sampled pages, scaled by 1/R, estimate the full-trace distances.  With
+ * mrc_max_samples set, the sample set is capped and T is lowered to the
+ * largest hash whenever it overflows (SHARDS_max), which keeps memory
+ * constant however many unique pages the trace touches.  Miss ratios are
+ * taken over the sampled weight rather than the trace length, so there is
+ * no SHARDS-adj correction of the smallest distance.
+ *
+ * FIFO and Clock are not stack algorithms, so they are estimated with
+ * miniature simulations: a cache of C*R pages fed the sampled references
+ * approximates a cache of C pages fed the full stream.
+ */
+#define MRC_HASH_SPACE (1u << 24)
+#define MRC_POINTS 32
+
+int mrc_enabled = 0;
+double mrc_rate = 0.01;
+int mrc_max_samples = 0;        /* > 0: fixed-size sample set */
+long mrc_verify_limit = 1000000;    /* compare with exact curves up to this length */
+
+/*
+ * LRU stack distances: each sampled page maps to the timestamp of its last
+ * reference, and a Fenwick tree over timestamps counts the pages referenced
+ * since.  Timestamps are renumbered densely when they run out.
+ */
+struct shards {
+    unsigned int threshold;
+    struct page_map last;       /* page -> timestamp */
+    int* tree;
+    unsigned long* owner;       /* timestamp -> page, for renumbering */
+    int tcap;
+    int next;
+    double* hist;               /* weight by scaled distance, last bin = miss */
+    int max_size;
+    int max_samples;            /* 0 = fixed rate */
+    double total;
+    long sampled;
+};
+
+void fenwick_add(int* tree, int n, int i, int delta) {
+    for (; i <= n; i += i & -i) tree[i] += delta;
+}
+
+int fenwick_sum(int* tree, int n, int i) {
+    int sum = 0;
+    if (i > n) i = n;
+    for (; i > 0; i -= i & -i) sum += tree[i];
+    return sum;
+}
+
+void shards_init(struct shards* s, double rate, int max_samples, int max_size) {
+    memset(s, 0, sizeof(*s));
+    s->threshold = rate >= 1.0 ? MRC_HASH_SPACE : (unsigned int)(rate * MRC_HASH_SPACE);
+    if (s->threshold == 0) s->threshold = 1;
+    page_map_init(&s->last, 1024);
+    s->tcap = 4096;
+    s->tree = calloc(s->tcap + 1, sizeof(int));
+    s->owner = calloc(s->tcap + 1, sizeof(unsigned long));
+    s->next = 1;
+    s->max_size = max_size;
+    s->max_samples = max_samples;
+    s->hist = calloc(max_size + 2, sizeof(double));
+}
+
+void shards_free(struct shards* s) {
+    page_map_free(&s->last);
+    free(s->tree);
+    free(s->owner);
+    free(s->hist);
+}
+
+/* Renumber live timestamps 1..count, growing the tree if it is half full */
+void shards_compact(struct shards* s) {
+    int t, n = 0;
+    int live = s->last.count;
+    int cap = s->tcap;
+    unsigned long* owner;
+    
+    while (live * 2 > cap) cap *= 2;
+    owner = calloc(cap + 1, sizeof(unsigned long));
+    for (t = 1; t < s->next; t++) {
+        if (fenwick_sum(s->tree, s->tcap, t) - fenwick_sum(s->tree, s->tcap, t - 1)) {
+            owner[++n] = s->owner[t];
+            page_map_put(&s->last, s->owner[t], n);
+        }
+    }
+    free(s->tree);
+    free(s->owner);
+    s->tcap = cap;
+    s->tree = calloc(cap + 1, sizeof(int));
+    s->owner = owner;
+    for (t = 1; t <= n; t++) fenwick_add(s->tree, cap, t, 1);
+    s->next = n + 1;
+}
+
+/* SHARDS_max: drop the sampled page with the largest hash and lower T to it */
+void shards_shrink(struct shards* s) {
+    unsigned int top = 0;
+    unsigned long victim = 0;
+    int i, t;
+    for (i = 0; i < s->last.cap; i++) {
+        if (s->last.used[i]) {
+            unsigned int h = page_hash(s->last.keys[i]) & (MRC_HASH_SPACE - 1);
+            if (h >= top) {
+                top = h;
+                victim = s->last.keys[i];
+            }
+        }
+    }
+    t = page_map_get(&s->last, victim);
+    fenwick_add(s->tree, s->tcap, t, -1);
+    page_map_del(&s->last, victim);
+    s->threshold = top;
+}
+
+void shards_access(struct shards* s, unsigned long page) {
+    double rate = (double)s->threshold / MRC_HASH_SPACE;
+    int t, bin;
+    
+    if ((page_hash(page) & (MRC_HASH_SPACE - 1)) >= s->threshold) return;
+    s->sampled++;
+    s->total += 1.0 / rate;
+    
+    if (s->next > s->tcap) shards_compact(s);
+    t = page_map_get(&s->last, page);
+    if (t < 0) {
+        bin = s->max_size + 1;
+    } else {
+        int distance = s->last.count - fenwick_sum(s->tree, s->tcap, t);
+        double scaled = distance / rate;
+        bin = scaled > s->max_size ? s->max_size + 1 : (int)scaled;
+        fenwick_add(s->tree, s->tcap, t, -1);
+    }
+    s->hist[bin] += 1.0 / rate;
+    
+    page_map_put(&s->last, page, s->next);
+    s->owner[s->next] = page;
+    fenwick_add(s->tree, s->tcap, s->next, 1);
+    s->next++;
+    
+    if (s->max_samples > 0 && s->last.count > s->max_samples) shards_shrink(s);
+}
+
+/* Miss ratio of an LRU cache of size frames */
+double shards_miss_ratio(struct shards* s, int size) {
+    double hits = 0.0;
+    int d;
+    if (s->total <= 0.0) return 0.0;
+    for (d = 0; d < size && d <= s->max_size; d++) hits += s->hist[d];
+    return 1.0 - hits / s->total;
+}
+
+/* Miniature FIFO (clock = 0) or Clock (clock = 1) cache */
+struct mini_cache {
+    int clock;
+    int size;
+    int used;
+    int hand;
+    unsigned long* pages;
+    char* ref;
+    struct page_map where;
+    long refs;
+    long misses;
+};
+
+void mini_init(struct mini_cache* c, int size, int clock) {
+    memset(c, 0, sizeof(*c));
+    c->clock = clock;
+    c->size = size < 1 ? 1 : size;
+    c->pages = calloc(c->size, sizeof(unsigned long));
+    c->ref = calloc(c->size, 1);
+    page_map_init(&c->where, c->size);
+}
+
+void mini_free(struct mini_cache* c) {
+    free(c->pages);
+    free(c->ref);
+    page_map_free(&c->where);
+}
+
+void mini_access(struct mini_cache* c, unsigned long page) {
+    int slot = page_map_get(&c->where, page);
+    c->refs++;
+    if (slot >= 0) {
+        c->ref[slot] = 1;
+        return;
+    }
+    c->misses++;
+    if (c->used < c->size) {
+        slot = c->used++;
+    } else {
+        while (c->clock && c->ref[c->hand]) {
+            c->ref[c->hand] = 0;
+            c->hand = (c->hand + 1) % c->size;
+        }
+        slot = c->hand;
+        c->hand = (c->hand + 1) % c->size;
+        page_map_del(&c->where, c->pages[slot]);
+    }
+    c->pages[slot] = page;
+    c->ref[slot] = 1;           /* like access_page, a new page starts referenced */
+    page_map_put(&c->where, page, slot);
+}
+
+double mini_miss_ratio(struct mini_cache* c) {
+    return c->refs > 0 ? (double)c->misses / c->refs : 0.0;
+}
+
+/*
+ * Estimates LRU/FIFO/Clock curves for one reference stream.  With rate 1.0
+ * and no sample cap every page is sampled and the curves are exact.  The
+ * miniature caches always use the fixed rate; the cap only applies to LRU.
+ */
+void mrc_curves(struct ref_stream* stream, double rate, int max_samples, int* sizes, int npoints,
+                double curve[3][MRC_POINTS], long* sampled) {
+    struct shards lru;
+    struct mini_cache fifo[MRC_POINTS], clock[MRC_POINTS];
+    unsigned int threshold = rate >= 1.0 ? MRC_HASH_SPACE : (unsigned int)(rate * MRC_HASH_SPACE);
+    int* batch;
+    int n, i, p;
     
-    pages = malloc(capacity * sizeof(int));
-    if (!pages) {
-        fclose(f);
-        return NULL;
+    shards_init(&lru, rate, max_samples, sizes[npoints - 1]);
+    for (p = 0; p < npoints; p++) {
+        int scaled = (int)(sizes[p] * rate + 0.5);
+        mini_init(&fifo[p], scaled, 0);
+        mini_init(&clock[p], scaled, 1);
     }
     
-    while (fgets(line, sizeof(line), f)) {
-        unsigned long addr;
-        if (sscanf(line, " L %lx", &addr) == 1) {
-            unsigned long page_num = addr / (page_size_kb * 1024);
-            int page = (int)(page_num % 1024);
-            pages[size++] = page;
-            
-            if (size >= capacity) {
-                capacity *= 2;
-                int* tmp = realloc(pages, capacity * sizeof(int));
-                if (!tmp) {
-                    free(pages);
-                    fclose(f);
-                    return NULL;
+    while ((n = stream_next(stream, &batch)) > 0) {
+        for (i = 0; i < n; i++) {
+            unsigned long page = (unsigned long)batch[i];
+            shards_access(&lru, page);
+            if ((page_hash(page) & (MRC_HASH_SPACE - 1)) < threshold) {
+                for (p = 0; p < npoints; p++) {
+                    mini_access(&fifo[p], page);
+                    mini_access(&clock[p], page);
                 }
-                pages = tmp;
             }
         }
     }
     
-    fclose(f);
-    *count = size;
-    return pages;
+    for (p = 0; p < npoints; p++) {
+        curve[0][p] = mini_miss_ratio(&fifo[p]);
+        curve[1][p] = shards_miss_ratio(&lru, sizes[p]);
+        curve[2][p] = mini_miss_ratio(&clock[p]);
+        mini_free(&fifo[p]);
+        mini_free(&clock[p]);
+    }
+    *sampled = lru.sampled;
+    shards_free(&lru);
 }
 
-void simulate_fifo(int* trace, int trace_size) {
-    int i, j, k;
-    volatile int dummy = 0;
+void run_mrc(char* name, char* binary, struct program_info* info, FILE* csv) {
+    double est[3][MRC_POINTS], exact[3][MRC_POINTS];
+    int sizes[MRC_POINTS];
+    int max_size = total_frames * 3;
+    int npoints = 0, step, p, a;
+    long sampled = 0, exact_sampled = 0;
+    struct ref_stream* stream;
     
-    for (i = 0; i < trace_size; i++) {
-        int page = trace[i];
-        access_page(page);
-        
-        for (j = 0; j < 5000; j++) {
-            dummy = dummy + j;
-            for (k = 0; k < 10; k++) {
-                dummy = dummy * 2 / 2;
+    if (max_size > 1024) max_size = 1024;
+    step = (max_size + MRC_POINTS - 1) / MRC_POINTS;
+    if (step < 1) step = 1;
+    for (p = step; p <= max_size && npoints < MRC_POINTS; p += step) sizes[npoints++] = p;
+    if (npoints == 0) return;
+    
+    stream = open_stream(name, binary, 0);
+    if (!stream) return;
+    mrc_curves(stream, mrc_rate, mrc_max_samples, sizes, npoints, est, &sampled);
+    info->mrc_verified = stream_length(stream) <= mrc_verify_limit;
+    close_stream(stream);
+    
+    info->mrc_sampled = sampled;
+    for (a = 0; a < 3; a++) info->mrc_error[a] = 0.0;
+    if (info->mrc_verified) {
+        stream = open_stream(name, binary, 0);
+        if (!stream) return;
+        mrc_curves(stream, 1.0, 0, sizes, npoints, exact, &exact_sampled);
+        close_stream(stream);
+        for (a = 0; a < 3; a++) {
+            for (p = 0; p < npoints; p++) info->mrc_error[a] += fabs(est[a][p] - exact[a][p]);
+            info->mrc_error[a] /= npoints;
+        }
+    }
+    
+    if (csv) {
+        for (p = 0; p < npoints; p++) {
+            fprintf(csv, "%s,%d,%.5f,%.5f,%.5f", name, sizes[p], est[0][p], est[1][p], est[2][p]);
+            if (info->mrc_verified) {
+                fprintf(csv, ",%.5f,%.5f,%.5f\n", exact[0][p], exact[1][p], exact[2][p]);
+            } else {
+                fprintf(csv, ",,,\n");
             }
         }
     }
 }
 
-void run_on_linux(char* program, struct program_info* info) {
-    double start, end;
+/*
+ * On-disk result cache.  A run's counters are stored in
+ * .vmm_cache/<key>.res, where the key hashes the reference stream (trace
+ * contents, or workload spec, size and seed), the memory geometry, the
+ * policy with its parameters, every option that changes the simulation,
+ * and VMM_SIM_VERSION.  Bump VMM_SIM_VERSION with any change to simulator
+ * behaviour so old entries stop matching.
+ */
+#define VMM_SIM_VERSION 16
+#define RESULT_CACHE_DIR ".vmm_cache"
 
-    start = get_time_ms();
- 
-    int workload_size = mem_size_kb * 1024 * 2;  /* 2x physical memory */
+int result_cache = 1;
+int result_cache_hits = 0;
+int result_cache_runs = 0;
+int memory_state_cached = 0;    /* last run came from the cache, frames not simulated */
+
+/* Counters from one simulated run; program_info fields derive from these */
+struct sim_result {
+    unsigned long long key;
+    double time_ms;
+    long total_accesses;
+    long simulated_runs;
+    int page_faults;
+    int swaps;
+    int swap_ins;
+    double total_fault_time;
+    double total_swap_out_time;
+    double total_swap_in_time;
+    long numa_accesses;
+    long numa_remote;
+    long numa_migrations;
+    double numa_access_ns;
+    long tier1_hits;
+    long tier2_hits;
+    long tier2_promotions;
+    long tier2_demotions;
+    long tier2_evictions;
+    double tier_access_ns;
+    long direct_reclaims;
+    long kswapd_reclaims;
+    long kswapd_wakeups;
+    double direct_reclaim_ms;
+    double kswapd_ms;
+    long swap_write_calls;
+    long swap_clean_drops;
+    long swap_slot_frees;
+    long swap_fallback_slots;
+    int swap_slots_used;
+    int swap_free_extents;
+    int swap_largest_free;
+    long forks_done;
+    long cow_faults;
+    long shared_peak;
+    double shared_sum;
+    long cow_swapouts_saved;
+    long cow_swapins_saved;
+    long file_reads;
+    long file_writebacks;
+    long file_drops;
+    long anon_reclaims;
+    long file_reclaims;
+    double file_io_time;
+    long pff_grows;
+    long pff_shrinks;
+    long pff_trims;
+    long pff_suspends;
+    long pff_resumes;
+    long pff_thrash_windows;
+    long pff_ticks;
+    double pff_limit_sum;
+    long pff_suspended_refs;
+    long mglru_walks;
+    long mglru_promotions;
+    long mglru_protected;
+    long mglru_refaults;
+    long mglru_tier_refaults[MGLRU_TIERS];
+    long lecar_evictions[2];
+    long lecar_ghost_hits[2];
+    double lecar_phase_weight[LECAR_PHASES];
+    struct swap_area_stats swap_area_stats[MAX_SWAP_AREAS];
+};
+
+#define HASH_VALUE(h, v) hash_bytes(h, (const char*)&(v), sizeof(v))
+
+unsigned long long result_key(char* name, struct ref_stream* s, int algorithm) {
+    unsigned long long h = hash_string("vmm-result");
+    int version = VMM_SIM_VERSION;
+    int a;
+    
+    h = HASH_VALUE(h, version);
+    if (s->use_workload) {
+        unsigned long long name_hash = hash_string(name);
+        h = hash_bytes(h, "W", 1);
+        h = hash_bytes(h, workload_spec_for(name), strlen(workload_spec_for(name)));
+        h = HASH_VALUE(h, s->wl.num_pages);
+        h = HASH_VALUE(h, s->wl.length);
+        h = HASH_VALUE(h, workload_seed);
+        h = HASH_VALUE(h, name_hash);
+    } else {
+        h = hash_bytes(h, "T", 1);
+        h = HASH_VALUE(h, s->trace_size);
+        h = HASH_VALUE(h, s->trace_refs);
+        h = hash_bytes(h, (const char*)s->trace, s->trace_size * sizeof(int));
+        if (s->counts) h = hash_bytes(h, (const char*)s->counts, s->trace_size * sizeof(int));
+    }
     
-    if (workload_size <= 0 || workload_size > 100 * 1024 * 1024) {
-        /* Safety check: limit to 100MB */
-        workload_size = 1024 * 1024;  /* Default 1MB */
+    h = HASH_VALUE(h, mem_size_kb);
+    h = HASH_VALUE(h, page_size_kb);
+    h = HASH_VALUE(h, total_frames);
+    h = HASH_VALUE(h, algorithm);
+    if (algorithm == 3) {
+        h = HASH_VALUE(h, aging_bits);
+        h = HASH_VALUE(h, aging_interval);
+    }
+    if (algorithm == 5) {
+        h = HASH_VALUE(h, lecar_rate);
+        h = HASH_VALUE(h, workload_seed);
+    }
+    h = HASH_VALUE(h, compute_work);
+    h = HASH_VALUE(h, trace_rle);
+    if (warmup_refs > 0) h = HASH_VALUE(h, warmup_refs);
+    h = HASH_VALUE(h, numa_nodes);
+    if (numa_nodes > 1) {
+        h = HASH_VALUE(h, numa_cpus);
+        h = HASH_VALUE(h, numa_quantum);
+        h = HASH_VALUE(h, numa_policy);
+        h = HASH_VALUE(h, numa_preferred);
+        h = HASH_VALUE(h, numa_migrate);
+        h = HASH_VALUE(h, numa_migrate_threshold);
+        h = HASH_VALUE(h, numa_local_ns);
+        h = HASH_VALUE(h, numa_remote_ns);
+    }
+    h = HASH_VALUE(h, tier2_frames);
+    if (tier2_frames > 0) {
+        h = HASH_VALUE(h, tier1_ns);
+        h = HASH_VALUE(h, tier2_ns);
+        h = HASH_VALUE(h, tier2_promote_hits);
+        h = HASH_VALUE(h, tier2_window);
+        h = HASH_VALUE(h, tier2_cooldown);
     }
+    h = HASH_VALUE(h, kswapd_enabled);
+    if (kswapd_enabled) {
+        h = HASH_VALUE(h, kswapd_low);
+        h = HASH_VALUE(h, kswapd_high);
+        h = HASH_VALUE(h, kswapd_interval);
+    }
+    h = HASH_VALUE(h, swap_cluster);
+    h = HASH_VALUE(h, swap_batch);
+    h = HASH_VALUE(h, write_percent);
+    h = HASH_VALUE(h, swap_area_count);
+    for (a = 0; a < swap_area_count; a++) {
+        h = HASH_VALUE(h, swap_areas[a].priority);
+        h = HASH_VALUE(h, swap_areas[a].slots);
+        h = hash_bytes(h, swap_areas[a].device_name, strlen(swap_areas[a].device_name));
+    }
+    h = hash_bytes(h, swap_device, strlen(swap_device));
+    h = hash_bytes(h, (const char*)device_profiles, device_profile_count * sizeof(device_profiles[0]));
+    h = HASH_VALUE(h, fork_count);
+    if (fork_count > 0) {
+        h = hash_bytes(h, (const char*)fork_refs, fork_count * sizeof(fork_refs[0]));
+        h = HASH_VALUE(h, fork_quantum);
+    }
+    h = HASH_VALUE(h, file_region_count);
+    if (file_region_count > 0) {
+        h = hash_bytes(h, (const char*)file_region_first, file_region_count * sizeof(int));
+        h = hash_bytes(h, (const char*)file_region_pages, file_region_count * sizeof(int));
+        h = hash_bytes(h, (const char*)file_region_writes, file_region_count * sizeof(int));
+        h = HASH_VALUE(h, swappiness);
+        h = hash_bytes(h, file_device, strlen(file_device));
+    }
+    h = HASH_VALUE(h, pff_enabled);
+    if (pff_enabled) {
+        h = HASH_VALUE(h, pff_window);
+        h = HASH_VALUE(h, pff_upper);
+        h = HASH_VALUE(h, pff_lower);
+        h = HASH_VALUE(h, pff_step);
+        h = HASH_VALUE(h, pff_min);
+    }
+    return h;
+}
+
+void result_cache_path(unsigned long long key, char* path, int size) {
+    snprintf(path, size, "%s/%016llx.res", RESULT_CACHE_DIR, key);
+}
+
+int load_cached_result(unsigned long long key, struct sim_result* r) {
+    char path[64];
+    FILE* f;
+    int ok;
     
-    char* linux_memory = (char*)malloc(workload_size);
+    result_cache_path(key, path, sizeof(path));
+    f = fopen(path, "rb");
+    if (!f) return 0;
+    ok = fread(r, sizeof(*r), 1, f) == 1 && r->key == key;
+    fclose(f);
+    return ok;
+}
+
+/* Written to a temporary name and renamed so readers never see a partial file */
+void store_cached_result(struct sim_result* r) {
+    char path[64], tmp[80];
+    FILE* f;
     
-    if (linux_memory) {
-        /* Access memory in a pattern that will cause Linux to page */
-        volatile int dummy = 0;
-        int page_size = 4096;
-        
-        for (int i = 0; i < workload_size; i += page_size) {
-            linux_memory[i] = (char)(i & 0xFF);
-            dummy += linux_memory[i];
+    mkdir(RESULT_CACHE_DIR, 0755);
+    result_cache_path(r->key, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    f = fopen(tmp, "wb");
+    if (!f) return;
+    if (fwrite(r, sizeof(*r), 1, f) == 1 && fclose(f) == 0) {
+        rename(tmp, path);
+    } else {
+        unlink(tmp);
+    }
+}
+
+/* Fill the program_info fields that belong to this algorithm's run.  A
+ * result replayed from the cache carries the timings of the run that
+ * stored it, so it stays out of the swap area totals. */
+void apply_result(struct program_info* info, struct sim_result* r, int algorithm, int cached) {
+    int a, i;
+    
+    if (algorithm < 0 || algorithm >= NUM_POLICIES) return;
+    info->policy_cached[algorithm] = cached;
+    if (!cached) {
+        for (a = 0; a < MAX_SWAP_AREAS; a++) {
+            struct swap_area_stats* t = &swap_area_totals[a];
+            t->pages_out += r->swap_area_stats[a].pages_out;
+            t->pages_in += r->swap_area_stats[a].pages_in;
+            t->requests += r->swap_area_stats[a].requests;
+            t->busy_ms += r->swap_area_stats[a].busy_ms;
+            t->latency_ms += r->swap_area_stats[a].latency_ms;
+            for (i = 0; i < 128; i++) t->latency_hist[i] += r->swap_area_stats[a].latency_hist[i];
+            if (r->swap_area_stats[a].max_latency_ms > t->max_latency_ms) {
+                t->max_latency_ms = r->swap_area_stats[a].max_latency_ms;
+            }
         }
-        
-        /* Random access pattern */
-        for (int i = 0; i < 1000; i++) {
-            int pos = ((i * 1103515245 + 12345) & 0x7FFFFFFF) % workload_size;
-            linux_memory[pos] = (char)i;
-            dummy += linux_memory[pos];
+        swap_area_runs++;
+    }
+    if (algorithm == 0) info->fifo_time = r->time_ms;
+    else if (algorithm == 1) info->lru_time = r->time_ms;
+    else if (algorithm == 2) info->clock_time = r->time_ms;
+    else if (algorithm == 3) info->aging_time = r->time_ms;
+    else if (algorithm == 4) info->mglru_time = r->time_ms;
+    else if (algorithm == 5) info->lecar_time = r->time_ms;
+    info->policy_faults[algorithm] = r->page_faults;
+    
+    if (algorithm == 4) {
+        info->mglru_walks = r->mglru_walks;
+        info->mglru_promotions = r->mglru_promotions;
+        info->mglru_protected = r->mglru_protected;
+        info->mglru_refaults = r->mglru_refaults;
+        for (i = 0; i < MGLRU_TIERS; i++) info->mglru_tier_refaults[i] = r->mglru_tier_refaults[i];
+    }
+    if (algorithm == 5) {
+        for (i = 0; i < 2; i++) {
+            info->lecar_evictions[i] = r->lecar_evictions[i];
+            info->lecar_ghost_hits[i] = r->lecar_ghost_hits[i];
         }
-        
-        free(linux_memory);
+        for (i = 0; i < LECAR_PHASES; i++) info->lecar_phase_weight[i] = r->lecar_phase_weight[i];
     }
     
-    end = get_time_ms();
+    if (algorithm == 0) {
+        info->total_accesses = r->total_accesses;
+        info->faults = r->page_faults;
+        info->swaps = r->swaps;
+        info->simulated_runs = r->simulated_runs;
+        info->avg_access_time = info->total_accesses > 0 ? (info->fifo_time / info->total_accesses) : 0.0;
+        info->avg_fault_time = info->faults > 0 ? (r->total_fault_time / info->faults) : 0.0;
+        info->avg_swap_out_time = info->swaps > 0 ? (r->total_swap_out_time / info->swaps) : 0.0;
+        info->avg_swap_in_time = r->swap_ins > 0 ? (r->total_swap_in_time / r->swap_ins) : 0.0;
+        info->total_io_time = r->total_swap_out_time + r->total_swap_in_time;
+        info->remote_ratio = r->numa_accesses > 0 ? (double)r->numa_remote / r->numa_accesses : 0.0;
+        info->migrations = r->numa_migrations;
+        info->avg_mem_ns = r->numa_accesses > 0 ? r->numa_access_ns / r->numa_accesses : 0.0;
+        info->tier1_hit_rate = info->total_accesses > 0 ? (double)r->tier1_hits / info->total_accesses : 0.0;
+        info->tier2_hit_rate = info->total_accesses > 0 ? (double)r->tier2_hits / info->total_accesses : 0.0;
+        info->promotions = r->tier2_promotions;
+        info->demotions = r->tier2_demotions;
+        info->tier2_evictions = r->tier2_evictions;
+        info->avg_tier_ns = r->tier1_hits + r->tier2_hits > 0 ?
+                            r->tier_access_ns / (r->tier1_hits + r->tier2_hits) : 0.0;
+        info->direct_reclaims = r->direct_reclaims;
+        info->kswapd_reclaims = r->kswapd_reclaims;
+        info->kswapd_wakeups = r->kswapd_wakeups;
+        info->direct_reclaim_ms = r->direct_reclaim_ms;
+        info->kswapd_ms = r->kswapd_ms;
+        info->swap_write_calls = r->swap_write_calls;
+        info->swap_clean_drops = r->swap_clean_drops;
+        info->swap_slot_frees = r->swap_slot_frees;
+        info->swap_fallback_slots = r->swap_fallback_slots;
+        info->swap_slots_used = r->swap_slots_used;
+        info->swap_free_extents = r->swap_free_extents;
+        info->swap_largest_free = r->swap_largest_free;
+        info->forks_done = r->forks_done;
+        info->cow_faults = r->cow_faults;
+        info->shared_peak = r->shared_peak;
+        info->avg_shared = r->total_accesses > 0 ? r->shared_sum / r->total_accesses : 0.0;
+        info->cow_swapouts_saved = r->cow_swapouts_saved;
+        info->cow_swapins_saved = r->cow_swapins_saved;
+        info->file_reads = r->file_reads;
+        info->file_writebacks = r->file_writebacks;
+        info->file_drops = r->file_drops;
+        info->anon_reclaims = r->anon_reclaims;
+        info->file_reclaims = r->file_reclaims;
+        info->file_io_time = r->file_io_time;
+        info->pff_grows = r->pff_grows;
+        info->pff_shrinks = r->pff_shrinks;
+        info->pff_trims = r->pff_trims;
+        info->pff_suspends = r->pff_suspends;
+        info->pff_resumes = r->pff_resumes;
+        info->pff_thrash_windows = r->pff_thrash_windows;
+        info->pff_avg_limit = r->pff_ticks > 0 ? r->pff_limit_sum / r->pff_ticks : 0.0;
+        info->pff_suspended_refs = r->pff_suspended_refs;
+    }
+}
+
+char warm_path[64] = "";        /* warm-start checkpoint of the program being run */
+
+/* Key of the warm-start checkpoint all of a program's policies share */
+unsigned long long warm_key(char* name, struct ref_stream* s) {
+    return hash_string("warmup") ^ result_key(name, s, 1);
+}
+
+/* Remove the warm-start checkpoint once the program's last policy has run */
+void warm_discard(void) {
+    if (!warm_path[0]) return;
+    unlink(warm_path);
+    warm_path[0] = '\0';
+}
+
+/* Warm start ("warmup <refs>").  The program's first references, up to the
+ * batch boundary past warmup_refs, are replayed once under LRU and kept as
+ * a checkpoint.  Every policy's run restores that state, adopts it and is
+ * measured from there, so no run pays for or counts the cold start. */
+void warm_start(char* name, struct ref_stream* s) {
+    unsigned long long key = warm_key(name, s);
+    int policy = algo;
     
-    info->linux_time = end - start;
-    info->memory_kb = mem_size_kb;  /* Use configured memory */
+    checkpoint_path(key, warm_path, sizeof(warm_path));
+    if (!checkpoint_read(s, key, 1)) {
+        algo = 1;
+        sim_stop = warmup_refs;
+        simulate_stream(s);
+        sim_stop = LONG_MAX;
+        checkpoint_write(s, key);
+        ckpt_clear_stats();
+        algo = policy;
+    }
+    policy_adopt();
+    sim_first_ref = lru_counter;
+    lecar_accounted = lru_counter;
 }
 
 void run_algo(char* name, long memory_kb, struct program_info* info, char* binary, int algorithm) {
-    double start, end;
-    char trace_file[512];
-    int* trace = NULL;
-    int trace_size = 0;
-    int num_pages = total_frames * 3;
-    int accesses = num_pages * 100;
-    int i;
+    double end;
+    struct ref_stream* stream;
+    struct sim_result r;
+    int free_slots, a;
+    
+    (void)memory_kb;            /* the geometry comes from the globals */
     
     if (algorithm == 0) {
         strcpy(info->name, name);
         info->memory_kb = mem_size_kb;  /* Use global config value */
     }
     
-    snprintf(trace_file, sizeof(trace_file), "%s.trace", binary);
-    
-    /* Try to load existing trace first, then try valgrind */
-    trace = load_trace(trace_file, &trace_size);
-    if ((!trace || trace_size == 0) && algorithm == 0) {
-        if (generate_trace_file(binary, trace_file)) {
-            trace = load_trace(trace_file, &trace_size);
-        }
-    }
-    
-    /* Generate synthetic trace with realistic patterns */
-    if (!trace || trace_size == 0) {
-        trace_size = accesses;
-        trace = malloc(trace_size * sizeof(int));
-        if (trace) {
-            /* Create different access patterns based on program name */
-            unsigned int seed = 12345 + algorithm;  /* Different seed per algo for variety */
-            
-            for (i = 0; i < trace_size; i++) {
-                if (strstr(name, "sequential")) {
-                    /* Sequential access with stride */
-                    trace[i] = (i / 8) % num_pages;
-                    if (i % 100 == 0) trace[i] = (trace[i] + num_pages/2) % num_pages;  /* Jump */
-                } else if (strstr(name, "random")) {
-                    /* Pure random access */
-                    seed = seed * 1103515245 + 12345;
-                    trace[i] = (seed / 65536) % num_pages;
-                } else if (strstr(name, "matrix")) {
-                    /* 2D matrix access (row-major then column-major) */
-                    int size = (int)sqrt(num_pages);
-                    if (i % 200 < 100) {
-                        int row = (i / 10) % size;
-                        int col = i % size;
-                        trace[i] = (row * size + col) % num_pages;
-                    } else {
-                        int col = (i / 10) % size;
-                        int row = i % size;
-                        trace[i] = (row * size + col) % num_pages;
-                    }
-                } else if (strstr(name, "linked_list")) {
-                    /* Pointer chasing - scattered access */
-                    trace[i] = ((i * 17 + 13) * (i + 1)) % num_pages;
-                } else if (strstr(name, "recursion") || strstr(name, "stack")) {
-                    /* Stack-like access with recursion depth */
-                    int depth = (i / 30) % 8;
-                    trace[i] = (num_pages - 1 - depth * 2 + (i % 5)) % num_pages;
-                } else if (strstr(name, "bubble") || strstr(name, "binary")) {
-                    /* Sorting/searching - repeated access to same regions */
-                    int region = (i / 50) % 4;
-                    int offset = i % 20;
-                    trace[i] = (region * (num_pages/4) + offset) % num_pages;
-                } else if (strstr(name, "hash")) {
-                    /* Hash table - scattered with some clustering */
-                    seed = seed * 1103515245 + 12345;
-                    int hash_val = (seed / 65536) % num_pages;
-                    trace[i] = (hash_val + (i % 3)) % num_pages;  /* Collision handling */
-                } else if (strstr(name, "string")) {
-                    /* String processing - sequential with periodic jumps */
-                    if (i % 50 < 40) {
-                        trace[i] = (i / 3) % num_pages;
-                    } else {
-                        trace[i] = ((i / 3) + num_pages/3) % num_pages;
-                    }
-                } else {
-                    /* Default: 70-30 locality (working set pattern) */
-                    if (i % 10 < 7) {
-                        /* 70% - access working set */
-                        int working_set_start = (i / 200) * 4;
-                        trace[i] = (working_set_start + (i % 4)) % num_pages;
-                    } else {
-                      
-                        seed = seed * 1103515245 + 12345;
-                        trace[i] = (seed / 65536) % num_pages;
-                    }
-                }
-            }
-        }
-    }
+    stream = open_stream(name, binary, algorithm == 0);
+    if (!stream) return;
     
-    if (trace && trace_size > 0) {
-        if (algorithm == 0) info->total_accesses = trace_size;
-    } else {
-        if (algorithm == 0) info->total_accesses = accesses;
+    memset(&r, 0, sizeof(r));
+    r.key = result_key(name, stream, algorithm);
+    result_cache_runs++;
+    if (result_cache && load_cached_result(r.key, &r)) {
+        close_stream(stream);
+        apply_result(info, &r, algorithm, 1);
+        result_cache_hits++;
+        memory_state_cached = 1;
+        return;
     }
+    r.total_accesses = stream_length(stream);
     
     algo = algorithm;
     init_memory();
+    simulated_runs = 0;
+    sim_first_ref = 0;
+    lecar_phase_len = r.total_accesses / LECAR_PHASES > 0 ? r.total_accesses / LECAR_PHASES : 1;
     
-    start = get_time_ms();
-    simulate_fifo(trace, trace_size);
-    end = get_time_ms();
-    
-    if (trace) free(trace);
+    sim_start_ms = get_time_ms();
+    ckpt_key = checkpoint_every > 0 ? r.key : 0;
+    if (ckpt_key && checkpoint_read(stream, ckpt_key, 0)) {
+        checkpoints_resumed++;
+    } else if (warmup_refs > 0) {
+        warm_start(name, stream);
+        sim_start_ms = get_time_ms();
+    }
+    ckpt_next = ckpt_key ? (lru_counter / checkpoint_every + 1) * checkpoint_every : LONG_MAX;
+    r.total_accesses -= sim_first_ref;
+    live_begin(name, algorithm, sim_first_ref, r.total_accesses);
     
-    if (algorithm == 0) info->fifo_time = end - start;
-    else if (algorithm == 1) info->lru_time = end - start;
-    else if (algorithm == 2) info->clock_time = end - start;
+    simulate_stream(stream);
+    end = get_time_ms();
+    live_end();
+    if (algo == 5) lecar_account();
+    if (ckpt_key) {
+        char path[64];
+        checkpoint_path(ckpt_key, path, sizeof(path));
+        unlink(path);
+        ckpt_key = 0;
+    }
+    close_stream(stream);
+    memory_state_cached = 0;
     
-    if (algorithm == 0) {
-        info->faults = page_faults;
-        info->swaps = swaps;
-        info->avg_access_time = info->total_accesses > 0 ? (info->fifo_time / info->total_accesses) : 0.0;
-        info->avg_fault_time = info->faults > 0 ? (total_fault_time / info->faults) : 0.0;
-        info->avg_swap_out_time = info->swaps > 0 ? (total_swap_out_time / info->swaps) : 0.0;
-        info->avg_swap_in_time = swap_ins > 0 ? (total_swap_in_time / swap_ins) : 0.0;
-        info->total_io_time = total_swap_out_time + total_swap_in_time;
+    r.time_ms = end - sim_start_ms + swap_model_skew_ms;  /* swap at modelled device speed */
+    r.simulated_runs = simulated_runs;
+    r.page_faults = page_faults;
+    r.swaps = swaps;
+    r.swap_ins = swap_ins;
+    r.total_fault_time = total_fault_time;
+    r.total_swap_out_time = total_swap_out_time;
+    r.total_swap_in_time = total_swap_in_time;
+    r.numa_accesses = numa_accesses;
+    r.numa_remote = numa_remote;
+    r.numa_migrations = numa_migrations;
+    r.numa_access_ns = numa_access_ns;
+    r.tier1_hits = tier1_hits;
+    r.tier2_hits = tier2_hits;
+    r.tier2_promotions = tier2_promotions;
+    r.tier2_demotions = tier2_demotions;
+    r.tier2_evictions = tier2_evictions;
+    r.tier_access_ns = tier_access_ns;
+    r.direct_reclaims = direct_reclaims;
+    r.kswapd_reclaims = kswapd_reclaims;
+    r.kswapd_wakeups = kswapd_wakeups;
+    r.direct_reclaim_ms = direct_reclaim_ms;
+    r.kswapd_ms = kswapd_ms;
+    r.swap_write_calls = swap_write_calls;
+    r.swap_clean_drops = swap_clean_drops;
+    r.swap_slot_frees = swap_slot_frees;
+    r.swap_fallback_slots = swap_fallback_slots;
+    r.swap_free_extents = swap_free_extents(&free_slots, &r.swap_largest_free);
+    r.swap_slots_used = swap_total_slots - free_slots;
+    r.forks_done = forks_done;
+    r.cow_faults = cow_faults;
+    r.shared_peak = shared_peak;
+    r.shared_sum = shared_sum;
+    r.cow_swapouts_saved = cow_swapouts_saved;
+    r.cow_swapins_saved = cow_swapins_saved;
+    r.file_reads = file_reads;
+    r.file_writebacks = file_writebacks;
+    r.file_drops = file_drops;
+    r.anon_reclaims = anon_reclaims;
+    r.file_reclaims = file_reclaims;
+    r.file_io_time = file_io_time;
+    r.pff_grows = pff_grows;
+    r.pff_shrinks = pff_shrinks;
+    r.pff_trims = pff_trims;
+    r.pff_suspends = pff_suspends;
+    r.pff_resumes = pff_resumes;
+    r.pff_thrash_windows = pff_thrash_windows;
+    r.pff_ticks = pff_ticks;
+    r.pff_limit_sum = pff_limit_sum;
+    r.pff_suspended_refs = pff_suspended_refs;
+    r.mglru_walks = mglru_walks;
+    r.mglru_promotions = mglru_promotions;
+    r.mglru_protected = mglru_protected;
+    r.mglru_refaults = mglru_refaults;
+    for (a = 0; a < MGLRU_TIERS; a++) r.mglru_tier_refaults[a] = mglru_tier_refaults[a];
+    for (a = 0; a < 2; a++) {
+        r.lecar_evictions[a] = lecar_evictions[a];
+        r.lecar_ghost_hits[a] = lecar_ghost_hits[a];
     }
+    for (a = 0; a < LECAR_PHASES; a++) {
+        r.lecar_phase_weight[a] = lecar_phase_refs[a] > 0 ? lecar_phase_sum[a] / lecar_phase_refs[a] : -1.0;
+    }
+    for (a = 0; a < swap_area_count; a++) r.swap_area_stats[a] = swap_areas[a].stats;
+    if (result_cache) store_cached_result(&r);
+    apply_result(info, &r, algorithm, 0);
+}
+
+/* A Linux run that finished under a cgroup memory.max.  RLIMIT_AS runs
+ * never page, so they are not compared with the policies */
+int linux_comparable(struct program_info* p) {
+    return p->linux_status == 0 && p->linux_limit_mode == LIMIT_CGROUP;
+}
+
+/* Run time of policy a (0 FIFO .. 5 LeCaR) */
+double policy_time(struct program_info* p, int a) {
+    double t[NUM_POLICIES] = { p->fifo_time, p->lru_time, p->clock_time, p->aging_time, p->mglru_time, p->lecar_time };
+    return t[a];
 }
 
+/* Times replayed from the result cache are those of the run that stored
+ * them, so they are marked and left out of the averages */
 void print_results(struct program_info programs[], int count) {
-    int i;
-    double avg_fifo = 0, avg_lru = 0, avg_clock = 0;
+    char label[32];
+    int i, a, timed[NUM_POLICIES] = {0}, cached = 0;
+    double avg[NUM_POLICIES] = {0};
     double avg_linux = 0;
+    int linux_ok = 0;
     int total_faults = 0;
     int total_swaps = 0;
     double total_io = 0.0;
+    int cached_io = 0;
+    int show_swap, show_mglru = 0, show_lecar = 0;
+    long total_refs = 0, total_runs = 0;
     
     printf("\n");
     printf("  Page Replacement Algorithm Performance Comparison\n");
     printf("\n");
-    printf("Program                  Memory   Faults  Swaps  FIFO Time   LRU Time    Clock Time\n");
-    printf("---------------------------------------------------------------------------------------------\n");
+    printf("Program                  Memory   Faults  Swaps  FIFO Time   LRU Time    Clock Time  Aging Time  MGLRU Time  LeCaR Time\n");
+    printf("----------------------------------------------------------------------------------------------------------------------------\n");
     
     for (i = 0; i < count; i++) {
-        printf("%-23s %6ld KB  %6d  %5d  %9.2f ms %9.2f ms %9.2f ms\n",
+        printf("%-23s %6ld KB  %6d  %5d ",
                programs[i].name,
                programs[i].memory_kb,
                programs[i].faults,
-               programs[i].swaps,
-               programs[i].fifo_time,
-               programs[i].lru_time,
-               programs[i].clock_time);
+               programs[i].swaps);
+        for (a = 0; a < NUM_POLICIES; a++) {
+            printf(" %9.2f ms%s", policy_time(&programs[i], a),
+                   programs[i].policy_cached[a] ? "*" : a < NUM_POLICIES - 1 ? " " : "");
+            if (programs[i].policy_cached[a]) {
+                cached = 1;
+                continue;
+            }
+            avg[a] += policy_time(&programs[i], a);
+            timed[a]++;
+        }
+        printf("\n");
         
-        avg_fifo += programs[i].fifo_time;
-        avg_lru += programs[i].lru_time;
-        avg_clock += programs[i].clock_time;
-        avg_linux += programs[i].linux_time;
+        if (linux_comparable(&programs[i])) {
+            avg_linux += programs[i].linux_time;
+            linux_ok++;
+        }
         total_faults += programs[i].faults;
         total_swaps += programs[i].swaps;
-        total_io += programs[i].total_io_time;
+        if (!programs[i].policy_cached[0]) total_io += programs[i].total_io_time;
+        else cached_io++;
+        total_refs += programs[i].total_accesses;
+        total_runs += programs[i].simulated_runs;
     }
     
-    printf("---------------------------------------------------------------------------------------------\n");
+    printf("----------------------------------------------------------------------------------------------------------------------------\n");
+    if (cached) printf("* replayed from the result cache (time of the run that stored it)\n");
     printf("\nSummary:\n");
-    printf("  Average FIFO Time:   %.2f ms\n", avg_fifo / count);
-    printf("  Average LRU Time:    %.2f ms\n", avg_lru / count);
-    printf("  Average Clock Time:  %.2f ms\n", avg_clock / count);
-    printf("  Average Linux Time:  %.2f ms\n", avg_linux / count);
+    for (a = 0; a < NUM_POLICIES; a++) {
+        snprintf(label, sizeof(label), "Average %s Time:", policy_names[a]);
+        if (timed[a] == 0) printf("  %-21sn/a (every run came from the result cache)\n", label);
+        else if (timed[a] < count) {
+            printf("  %-21s%.2f ms (%d of %d runs; cached runs excluded)\n", label, avg[a] / timed[a], timed[a], count);
+        } else printf("  %-21s%.2f ms\n", label, avg[a] / timed[a]);
+    }
+    if (linux_ok > 0) {
+        printf("  Average Linux Time:  %.2f ms (%d of %d runs; failed and unconstrained runs excluded)\n",
+               avg_linux / linux_ok, linux_ok, count);
+    } else {
+        printf("  Average Linux Time:  n/a (no Linux run succeeded under a cgroup limit)\n");
+    }
     printf("  Total Page Faults:   %d\n", total_faults);
     printf("  Total Swaps to Disk: %d\n", total_swaps);
-    printf("  Total I/O Time:      %.2f ms\n", total_io);
+    if (cached_io == count) printf("  Total I/O Time:      n/a (every FIFO run came from the result cache)\n");
+    else if (cached_io > 0) printf("  Total I/O Time:      %.2f ms (cached FIFO runs excluded)\n", total_io);
+    else printf("  Total I/O Time:      %.2f ms\n", total_io);
+    if (trace_rle && total_runs > 0) {
+        printf("  Run-length reduced:  %ld refs simulated as %ld accesses (%.1fx)\n",
+               total_refs, total_runs, (double)total_refs / total_runs);
+    }
+    if (result_cache) {
+        printf("  Result cache:        %d of %d runs reused from %s/\n",
+               result_cache_hits, result_cache_runs, RESULT_CACHE_DIR);
+    }
+    if (checkpoint_every > 0) {
+        printf("  Checkpoints:         every %ld refs in %s/, %d written, %d runs resumed\n",
+               checkpoint_every, CHECKPOINT_DIR, checkpoints_written, checkpoints_resumed);
+    }
+    if (warmup_refs > 0) {
+        printf("  Warm start:          first %ld refs replayed once under LRU, not counted\n", warmup_refs);
+    }
     printf("\nConfig: %d KB memory, %d KB pages, %d frames\n", 
            mem_size_kb, page_size_kb, total_frames);
+    
+    printf("\nPage faults by policy (Aging: %d-bit counters, tick every %ld refs)\n",
+           aging_bits, aging_interval);
+    printf("Program                    FIFO     LRU   Clock   Aging   MGLRU   LeCaR\n");
+    printf("-----------------------------------------------------------------------\n");
+    for (i = 0; i < count; i++) {
+        printf("%-23s %7d %7d %7d %7d %7d %7d\n",
+               programs[i].name,
+               programs[i].policy_faults[0],
+               programs[i].policy_faults[1],
+               programs[i].policy_faults[2],
+               programs[i].policy_faults[3],
+               programs[i].policy_faults[4],
+               programs[i].policy_faults[5]);
+    }
+    
+    printf("\nLinux baseline: programs run natively, capped by cgroup v2 memory.max (configured memory\n");
+    printf("plus %ld KB runtime baseline) or else setrlimit(RLIMIT_AS) (footprint plus baseline);\n",
+           linux_baseline_kb);
+    printf("RLIMIT_AS runs cannot page, so they are unconstrained and left out of the comparison\n");
+    printf("Program                  Wall Time   Major   Minor  Swap In  Swap Out  Status          Limit\n");
+    printf("-------------------------------------------------------------------------------------------------\n");
+    for (i = 0; i < count; i++) {
+        char status[32], wall[32];
+        if (programs[i].linux_status == -1 && programs[i].linux_limit_mode == LIMIT_NONE) strcpy(status, "not run");
+        else if (programs[i].linux_status < 0) snprintf(status, sizeof(status), "failed: sig %d", -programs[i].linux_status);
+        else if (programs[i].linux_status == 127) strcpy(status, "failed: exec");
+        else if (programs[i].linux_status != 0) snprintf(status, sizeof(status), "failed: exit %d", programs[i].linux_status);
+        else if (programs[i].linux_limit_mode == LIMIT_RLIMIT) strcpy(status, "unconstrained");
+        else strcpy(status, "ok");
+        if (programs[i].linux_status == 0) snprintf(wall, sizeof(wall), "%9.2f ms", programs[i].linux_time);
+        else snprintf(wall, sizeof(wall), "%12s", "-");
+        printf("%-23s %s %6ld %7ld %8ld %9ld  %-15s %s %ld KB (%s)\n",
+               programs[i].name,
+               wall,
+               programs[i].linux_major_faults,
+               programs[i].linux_minor_faults,
+               programs[i].linux_swap_in,
+               programs[i].linux_swap_out,
+               status,
+               programs[i].linux_limit_mode == LIMIT_CGROUP ? "cgroup" :
+               programs[i].linux_limit_mode == LIMIT_RLIMIT ? "RLIMIT_AS" : "none",
+               programs[i].linux_limit_used_kb,
+               programs[i].linux_limit_why);
+    }
+    
+    if (pager_enabled) {
+        printf("\nUserspace pager: real programs, %d resident pages, end-to-end runtime\n", total_frames);
+        printf("Program                  FIFO Time  Faults   LRU Time  Faults  Clock Time  Faults  Linux Time\n");
+        printf("------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            if (!programs[i].pager_ok) {
+                printf("%-23s   (pager unavailable: needs userfaultfd and page size a multiple of %ld)\n",
+                       programs[i].name, sysconf(_SC_PAGESIZE));
+                continue;
+            }
+            printf("%-23s %7.2f ms %7ld %7.2f ms %7ld %8.2f ms %7ld ",
+                   programs[i].name,
+                   programs[i].pager_time[0], programs[i].pager_faults[0],
+                   programs[i].pager_time[1], programs[i].pager_faults[1],
+                   programs[i].pager_time[2], programs[i].pager_faults[2]);
+            if (linux_comparable(&programs[i])) printf("%8.2f ms\n", programs[i].linux_time);
+            else if (programs[i].linux_status == 0) printf("%s\n", "unconstrained");
+            else printf("%11s\n", "failed");
+        }
+    }
+    
+    if (mrc_enabled) {
+        if (mrc_max_samples > 0) {
+            printf("\nSampled miss-ratio curves (SHARDS, at most %d sampled pages), full curves in mrc.csv\n",
+                   mrc_max_samples);
+        } else {
+            printf("\nSampled miss-ratio curves (SHARDS, rate %.4f), full curves in mrc.csv\n", mrc_rate);
+        }
+        printf("Program                  Sampled Refs   FIFO Err   LRU Err  Clock Err\n");
+        printf("-----------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            if (programs[i].mrc_verified) {
+                printf("%-23s %13ld   %8.4f  %8.4f   %8.4f\n",
+                       programs[i].name, programs[i].mrc_sampled,
+                       programs[i].mrc_error[0], programs[i].mrc_error[1], programs[i].mrc_error[2]);
+            } else {
+                printf("%-23s %13ld   (trace longer than mrc_verify_limit, not verified)\n",
+                       programs[i].name, programs[i].mrc_sampled);
+            }
+        }
+    }
+    
+    if (numa_nodes > 1) {
+        char* policies[] = { "first-touch", "interleave", "preferred" };
+        printf("\nNUMA: %d nodes, %d CPUs, %s placement, migration %s (FIFO run)\n",
+               numa_nodes, numa_cpus, policies[numa_policy], numa_migrate ? "on" : "off");
+        printf("Program                  Remote %%  Migrations  Avg Access\n");
+        printf("-----------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            printf("%-23s %8.1f%%  %10ld  %7.1f ns\n",
+                   programs[i].name,
+                   programs[i].remote_ratio * 100.0,
+                   programs[i].migrations,
+                   programs[i].avg_mem_ns);
+        }
+    }
+    
+    if (tier2_frames > 0) {
+        printf("\nSlow tier: %d frames, %.0f ns vs %.0f ns, promote after %d hits/%d refs (FIFO run)\n",
+               tier2_frames, tier2_ns, tier1_ns, tier2_promote_hits, tier2_window);
+        printf("Program                  Fast Hit  Slow Hit  Promoted  Demoted  To Swap  Avg Access\n");
+        printf("-----------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            printf("%-23s %8.1f%% %8.1f%%  %8ld  %7ld  %7ld  %7.1f ns\n",
+                   programs[i].name,
+                   programs[i].tier1_hit_rate * 100.0,
+                   programs[i].tier2_hit_rate * 100.0,
+                   programs[i].promotions,
+                   programs[i].demotions,
+                   programs[i].tier2_evictions,
+                   programs[i].avg_tier_ns);
+        }
+    }
+    
+    if (kswapd_enabled) {
+        printf("\nBackground reclaim: wake below %d free frames, refill to %d, slice every %ld refs (FIFO run)\n",
+               kswapd_low_frames, kswapd_high_frames, kswapd_interval);
+        printf("Program                  Faults  Direct  Direct %%  kswapd  Wakeups  Direct Time  kswapd Time  Off Path\n");
+        printf("------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            double reclaim_ms = programs[i].direct_reclaim_ms + programs[i].kswapd_ms;
+            printf("%-23s %6d %7ld %8.1f%% %7ld %8ld %9.2f ms %9.2f ms %8.1f%%\n",
+                   programs[i].name,
+                   programs[i].faults,
+                   programs[i].direct_reclaims,
+                   programs[i].faults > 0 ? 100.0 * programs[i].direct_reclaims / programs[i].faults : 0.0,
+                   programs[i].kswapd_reclaims,
+                   programs[i].kswapd_wakeups,
+                   programs[i].direct_reclaim_ms,
+                   programs[i].kswapd_ms,
+                   reclaim_ms > 0 ? 100.0 * programs[i].kswapd_ms / reclaim_ms : 0.0);
+        }
+    }
+    
+    /* Like the tables above, the swap space, MGLRU and LeCaR tables appear
+     * only when their feature is configured or did something in some run */
+    show_swap = swap_batch > 1 || write_percent < 100;
+    for (i = 0; i < count; i++) {
+        if (programs[i].swap_clean_drops > 0 || programs[i].swap_fallback_slots > 0) show_swap = 1;
+        if (programs[i].mglru_promotions > 0 || programs[i].mglru_protected > 0 ||
+            programs[i].mglru_refaults > 0) show_mglru = 1;
+        if (programs[i].lecar_evictions[1] > 0 || programs[i].lecar_ghost_hits[0] > 0 ||
+            programs[i].lecar_ghost_hits[1] > 0) show_lecar = 1;
+    }
+    
+    if (show_swap) {
+        /* Fragmentation: share of the free slots outside the longest free extent */
+        printf("\nSwap space: %d slots in clusters of %d, %d victim%s per direct reclaim, %d%% writes (FIFO run)\n",
+               swap_total_slots, swap_cluster, swap_batch, swap_batch == 1 ? "" : "s", write_percent);
+        printf("Program                 Written  Writes  Pages/Write  Clean Drops  Freed  Fallback  In Use  Extents   Frag\n");
+        printf("--------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            int free_slots = swap_total_slots - programs[i].swap_slots_used;
+            printf("%-23s %7d %7ld %12.2f %12ld %6ld %9ld %7d %8d %5.1f%%\n",
+                   programs[i].name,
+                   programs[i].swaps,
+                   programs[i].swap_write_calls,
+                   programs[i].swap_write_calls > 0 ? (double)programs[i].swaps / programs[i].swap_write_calls : 0.0,
+                   programs[i].swap_clean_drops,
+                   programs[i].swap_slot_frees,
+                   programs[i].swap_fallback_slots,
+                   programs[i].swap_slots_used,
+                   programs[i].swap_free_extents,
+                   free_slots > 0 ? 100.0 * (free_slots - programs[i].swap_largest_free) / free_slots : 0.0);
+        }
+    }
+    
+    if (fork_count > 0) {
+        /* Shared mappings are child page-table entries pointing at a
+         * parent's frame, i.e. frames a copying fork would have used */
+        printf("\nCopy-on-write fork: %d fork%s, quantum %d refs (FIFO run)\n",
+               fork_count, fork_count == 1 ? "" : "s", fork_quantum);
+        if (fork_pages_folded) {
+            printf("Each process has %d pages: larger workloads were capped and traces folded,\n"
+                   "so these fault counts are not comparable with runs without fork\n", PROC_PAGES);
+        }
+        printf("Program                  Forks  COW Faults  Peak Shared  Avg Shared  Swap-outs Saved  Swap-ins Saved   Swaps\n");
+        printf("-----------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            printf("%-23s %6ld %11ld %12ld %11.1f %16ld %15ld %7d\n",
+                   programs[i].name,
+                   programs[i].forks_done,
+                   programs[i].cow_faults,
+                   programs[i].shared_peak,
+                   programs[i].avg_shared,
+                   programs[i].cow_swapouts_saved,
+                   programs[i].cow_swapins_saved,
+                   programs[i].swaps);
+        }
+    }
+    
+    if (file_region_count > 0) {
+        int file_pages = 0;
+        for (i = 0; i < file_region_count; i++) file_pages += file_region_pages[i];
+        printf("\nPage cache: %d file-backed page%s in %d region%s, swappiness %d (FIFO run)\n",
+               file_pages, file_pages == 1 ? "" : "s", file_region_count, file_region_count == 1 ? "" : "s",
+               swappiness);
+        printf("Program                 File Reads  Writebacks  Clean Drops  Anon Reclaims  File Reclaims   Swaps   File I/O   Swap I/O\n");
+        printf("-----------------------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            printf("%-23s %10ld %11ld %12ld %14ld %14ld %7d %7.2f ms %7.2f ms\n",
+                   programs[i].name,
+                   programs[i].file_reads,
+                   programs[i].file_writebacks,
+                   programs[i].file_drops,
+                   programs[i].anon_reclaims,
+                   programs[i].file_reclaims,
+                   programs[i].swaps,
+                   programs[i].file_io_time,
+                   programs[i].total_io_time);
+        }
+    }
+    
+    if (pff_enabled) {
+        /* Demand is the running processes' limits summed, averaged over windows */
+        printf("\nPFF resident sets: window %d refs, grow above %.0f, shrink below %.0f faults/1000 refs (FIFO run)\n",
+               pff_window, pff_upper, pff_lower);
+        printf("Program                  Faults  Grows  Shrinks  Pages Trimmed  Thrashing  Suspends  Resumes  Avg Demand  Suspended Refs\n");
+        printf("----------------------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            printf("%-23s %7d %6ld %8ld %14ld %10ld %9ld %8ld %11.1f %15ld\n",
+                   programs[i].name,
+                   programs[i].faults,
+                   programs[i].pff_grows,
+                   programs[i].pff_shrinks,
+                   programs[i].pff_trims,
+                   programs[i].pff_thrash_windows,
+                   programs[i].pff_suspends,
+                   programs[i].pff_resumes,
+                   programs[i].pff_avg_limit,
+                   programs[i].pff_suspended_refs);
+        }
+    }
+    
+    if (show_mglru) {
+        /* Refaults are evicted pages faulted back within one memory's worth of
+         * evictions, split by the tier they were evicted from */
+        printf("\nMGLRU: %d generations minimum, %d tiers (MGLRU run)\n", MGLRU_MIN_GENS, MGLRU_TIERS);
+        printf("Program                  Faults  Linux Major   Walks  Promotions  Protected  Refaults  Tier 0  Tier 1  Tier 2  Tier 3\n");
+        printf("--------------------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            printf("%-23s %7d %12ld %7ld %11ld %10ld %9ld %7ld %7ld %7ld %7ld\n",
+                   programs[i].name,
+                   programs[i].policy_faults[4],
+                   programs[i].linux_major_faults,
+                   programs[i].mglru_walks,
+                   programs[i].mglru_promotions,
+                   programs[i].mglru_protected,
+                   programs[i].mglru_refaults,
+                   programs[i].mglru_tier_refaults[0],
+                   programs[i].mglru_tier_refaults[1],
+                   programs[i].mglru_tier_refaults[2],
+                   programs[i].mglru_tier_refaults[3]);
+        }
+    }
+    
+    if (show_lecar) {
+        /* Phases are eighths of the reference stream; the weight is the chance
+         * an eviction follows LRU, averaged over the phase's references */
+        printf("\nLeCaR: learning rate %.2f, LRU expert weight by phase (LeCaR run)\n", lecar_rate);
+        printf("Program                  Faults  LRU Evict  LFU Evict  LRU Regret  LFU Regret   P1   P2   P3   P4   P5   P6   P7   P8\n");
+        printf("-----------------------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < count; i++) {
+            int p;
+            printf("%-23s %7d %10ld %10ld %11ld %11ld ",
+                   programs[i].name,
+                   programs[i].policy_faults[5],
+                   programs[i].lecar_evictions[0],
+                   programs[i].lecar_evictions[1],
+                   programs[i].lecar_ghost_hits[0],
+                   programs[i].lecar_ghost_hits[1]);
+            for (p = 0; p < LECAR_PHASES; p++) {
+                if (programs[i].lecar_phase_weight[p] < 0) printf("    -");
+                else printf(" %.2f", programs[i].lecar_phase_weight[p]);
+            }
+            printf("\n");
+        }
+    }
+    
+    if (swap_areas_configured) {
+        if (swap_area_runs < result_cache_runs) {
+            printf("\nSwap areas (%d of %d runs; cached runs excluded)\n", swap_area_runs, result_cache_runs);
+        } else printf("\nSwap areas (all runs)\n");
+        printf("Area                      Device  Priority  Slots  Pages Out  Pages In  Requests  Throughput  Avg Latency  P99 Latency  Max Latency\n");
+        printf("---------------------------------------------------------------------------------------------------------------------------------\n");
+        for (i = 0; i < swap_area_count; i++) {
+            struct swap_area_stats* t = &swap_area_totals[i];
+            printf("%-25s %-6s %9d %6d %10ld %9ld %9ld %6.1f MB/s %8.3f ms %9.3f ms %8.3f ms\n",
+                   swap_areas[i].path,
+                   swap_device_name(i),
+                   swap_areas[i].priority,
+                   swap_areas[i].nslots,
+                   t->pages_out,
+                   t->pages_in,
+                   t->requests,
+                   t->busy_ms > 0 ? (t->pages_out + t->pages_in) * page_size_kb / 1024.0 / (t->busy_ms / 1000.0) : 0.0,
+                   t->requests > 0 ? t->latency_ms / t->requests : 0.0,
+                   latency_percentile(t, 0.99),
+                   t->max_latency_ms);
+        }
+    }
 }
 
 void print_memory_map(void) {
@@ -512,15 +5689,20 @@ void print_memory_map(void) {
     
     printf("\n  Memory Map Snapshot\n");
     printf("  ===================\n");
-    printf("  Frame | Page | Status\n");
-    printf("  ------+------+--------\n");
+    if (memory_state_cached) {
+        printf("  Not available: the last run was served from the result cache\n");
+        printf("  (set result_cache 0 in config.txt to simulate every run)\n");
+        return;
+    }
+    printf("  Frame | Node | Page | Status\n");
+    printf("  ------+------+------+--------\n");
     
     for (i = 0; i < total_frames; i++) {
         if (frame_occupied[i]) {
-            printf("  %4d  | %4d | In Memory\n", i, frame_to_page[i]);
+            printf("  %4d  | %4d | %4d | In Memory\n", i, frame_node[i], frame_to_page[i]);
             occupied++;
         } else {
-            printf("  %4d  |  --  | Free\n", i);
+            printf("  %4d  | %4d |  --  | Free\n", i, frame_node[i]);
         }
     }
     
@@ -531,6 +5713,13 @@ void print_memory_map(void) {
     }
     
     printf("\n  Frames in use: %d / %d\n", occupied, total_frames);
+    if (tier2_frames > 0) {
+        int in_tier2 = 0;
+        for (i = 0; i < tier2_frames; i++) {
+            if (tier2_slot_page[i] >= 0) in_tier2++;
+        }
+        printf("  Slow tier in use: %d / %d\n", in_tier2, tier2_frames);
+    }
     printf("  Pages on disk: %d\n", on_disk);
 }
 
@@ -540,7 +5729,10 @@ void generate_html(struct program_info programs[], int count) {
     int i;
     double max_time = 0.0;
     int max_faults = 0;
-    double avg_fifo = 0, avg_lru = 0, avg_clock = 0, avg_linux = 0;
+    double avg_fifo = 0, avg_lru = 0, avg_clock = 0, avg_aging = 0, avg_mglru = 0, avg_lecar = 0, avg_linux = 0;
+    double avg[NUM_POLICIES] = {0};
+    int linux_ok = 0, timed[NUM_POLICIES] = {0}, cached = 0, a;
+    int io_timed = 0;
     int total_faults = 0, total_swaps = 0;
     double total_io = 0.0;
     
@@ -550,20 +5742,41 @@ void generate_html(struct program_info programs[], int count) {
         if (programs[i].fifo_time > max_time) max_time = programs[i].fifo_time;
         if (programs[i].lru_time > max_time) max_time = programs[i].lru_time;
         if (programs[i].clock_time > max_time) max_time = programs[i].clock_time;
-        if (programs[i].linux_time > max_time) max_time = programs[i].linux_time;
+        if (programs[i].aging_time > max_time) max_time = programs[i].aging_time;
+        if (programs[i].mglru_time > max_time) max_time = programs[i].mglru_time;
+        if (programs[i].lecar_time > max_time) max_time = programs[i].lecar_time;
+        if (linux_comparable(&programs[i]) && programs[i].linux_time > max_time) max_time = programs[i].linux_time;
         if (programs[i].faults > max_faults) max_faults = programs[i].faults;
-        avg_fifo += programs[i].fifo_time;
-        avg_lru += programs[i].lru_time;
-        avg_clock += programs[i].clock_time;
-        avg_linux += programs[i].linux_time;
+        for (a = 0; a < NUM_POLICIES; a++) {
+            if (programs[i].policy_cached[a]) {
+                cached = 1;
+                continue;
+            }
+            avg[a] += policy_time(&programs[i], a);
+            timed[a]++;
+        }
+        if (linux_comparable(&programs[i])) {
+            avg_linux += programs[i].linux_time;
+            linux_ok++;
+        }
         total_faults += programs[i].faults;
         total_swaps += programs[i].swaps;
-        total_io += programs[i].total_io_time;
+        if (!programs[i].policy_cached[0]) {
+            total_io += programs[i].total_io_time;
+            io_timed++;
+        }
     }
-    avg_fifo /= count;
-    avg_lru /= count;
-    avg_clock /= count;
-    avg_linux /= count;
+    /* Cached runs are left out, as in print_results */
+    for (a = 0; a < NUM_POLICIES; a++) {
+        if (timed[a] > 0) avg[a] /= timed[a];
+    }
+    avg_fifo = avg[0];
+    avg_lru = avg[1];
+    avg_clock = avg[2];
+    avg_aging = avg[3];
+    avg_mglru = avg[4];
+    avg_lecar = avg[5];
+    if (linux_ok > 0) avg_linux /= linux_ok;
     
     fprintf(f, "<!DOCTYPE html>\n<html>\n<head>\n");
     fprintf(f, "<meta charset='UTF-8'>\n");
@@ -600,6 +5813,9 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, ".fifo-badge { background: linear-gradient(135deg, #ff6b6b, #ee5a6f); color: white; }\n");
     fprintf(f, ".lru-badge { background: linear-gradient(135deg, #4ecdc4, #44a08d); color: white; }\n");
     fprintf(f, ".clock-badge { background: linear-gradient(135deg, #f093fb, #f5576c); color: white; }\n");
+    fprintf(f, ".aging-badge { background: linear-gradient(135deg, #fbbf24, #d97706); color: white; }\n");
+    fprintf(f, ".mglru-badge { background: linear-gradient(135deg, #818cf8, #4f46e5); color: white; }\n");
+    fprintf(f, ".lecar-badge { background: linear-gradient(135deg, #a3e635, #4d7c0f); color: white; }\n");
     fprintf(f, ".memory-map { display: grid; grid-template-columns: repeat(auto-fill, minmax(55px, 1fr)); gap: 8px; padding: 25px; }\n");
     fprintf(f, ".frame-box { padding: 12px; border-radius: 10px; text-align: center; font-size: 0.85em; border: 2px solid; font-weight: 600; transition: all 0.3s; cursor: pointer; }\n");
     fprintf(f, ".frame-box:hover { transform: scale(1.1); box-shadow: 0 5px 15px rgba(0,0,0,0.3); }\n");
@@ -626,16 +5842,24 @@ void generate_html(struct program_info programs[], int count) {
             mem_size_kb, page_size_kb, total_frames);
     fprintf(f, "</div>\n");
     
-    /* Determine winner */
-    double min_time = avg_fifo;
-    char* winner = "FIFO";
-    if (avg_lru < min_time) { min_time = avg_lru; winner = "LRU"; }
-    if (avg_clock < min_time) { min_time = avg_clock; winner = "Clock"; }
+    /* Determine winner among the policies with timed runs */
+    double min_time = 0.0;
+    char* winner = "n/a";
+    for (a = 0; a < NUM_POLICIES; a++) {
+        if (timed[a] > 0 && (winner[0] == 'n' || avg[a] < min_time)) {
+            min_time = avg[a];
+            winner = policy_names[a];
+        }
+    }
     
     fprintf(f, "<div class='winner-card'>\n");
     fprintf(f, "<h2>Best Performing Algorithm</h2>\n");
     fprintf(f, "<div class='algo-name'>%s</div>\n", winner);
-    fprintf(f, "<p style='color: #8b4513; font-size: 1.2em; margin-top: 10px;'>Average Time: %.2f ms</p>\n", min_time);
+    if (winner[0] == 'n') {
+        fprintf(f, "<p style='color: #8b4513; font-size: 1.2em; margin-top: 10px;'>Every run came from the result cache</p>\n");
+    } else {
+        fprintf(f, "<p style='color: #8b4513; font-size: 1.2em; margin-top: 10px;'>Average Time: %.2f ms</p>\n", min_time);
+    }
     fprintf(f, "</div>\n");
     
     /* Statistics Cards */
@@ -644,25 +5868,50 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "<div class='stat-card'>\n");
     fprintf(f, "<div class='stat-icon'></div>\n");
     fprintf(f, "<div class='stat-label'>FIFO Average</div>\n");
-    fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_fifo);
+    if (timed[0] > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_fifo);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
     fprintf(f, "</div>\n");
     
     fprintf(f, "<div class='stat-card'>\n");
     fprintf(f, "<div class='stat-icon'></div>\n");
     fprintf(f, "<div class='stat-label'>LRU Average</div>\n");
-    fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_lru);
+    if (timed[1] > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_lru);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
     fprintf(f, "</div>\n");
     
     fprintf(f, "<div class='stat-card'>\n");
     fprintf(f, "<div class='stat-icon'></div>\n");
     fprintf(f, "<div class='stat-label'>Clock Average</div>\n");
-    fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_clock);
+    if (timed[2] > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_clock);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
+    fprintf(f, "</div>\n");
+    
+    fprintf(f, "<div class='stat-card'>\n");
+    fprintf(f, "<div class='stat-icon'></div>\n");
+    fprintf(f, "<div class='stat-label'>Aging Average</div>\n");
+    if (timed[3] > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_aging);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
+    fprintf(f, "</div>\n");
+    
+    fprintf(f, "<div class='stat-card'>\n");
+    fprintf(f, "<div class='stat-icon'></div>\n");
+    fprintf(f, "<div class='stat-label'>MGLRU Average</div>\n");
+    if (timed[4] > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_mglru);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
+    fprintf(f, "</div>\n");
+    
+    fprintf(f, "<div class='stat-card'>\n");
+    fprintf(f, "<div class='stat-icon'></div>\n");
+    fprintf(f, "<div class='stat-label'>LeCaR Average</div>\n");
+    if (timed[5] > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_lecar);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
     fprintf(f, "</div>\n");
     
     fprintf(f, "<div class='stat-card'>\n");
     fprintf(f, "<div class='stat-icon'></div>\n");
     fprintf(f, "<div class='stat-label'>Linux Native</div>\n");
-    fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_linux);
+    if (linux_ok > 0) fprintf(f, "<div class='stat-value'>%.2f ms</div>\n", avg_linux);
+    else fprintf(f, "<div class='stat-value'>n/a</div>\n");
     fprintf(f, "</div>\n");
     
     fprintf(f, "<div class='stat-card'>\n");
@@ -680,14 +5929,15 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "<div class='stat-card'>\n");
     fprintf(f, "<div class='stat-icon'></div>\n");
     fprintf(f, "<div class='stat-label'>Total I/O Time</div>\n");
-    fprintf(f, "<div class='stat-value'>%.1f ms</div>\n", total_io);
+    if (io_timed > 0) fprintf(f, "<div class='stat-value'>%.1f ms</div>\n", total_io);
+    else fprintf(f, "<div class='stat-value'>cached</div>\n");
     fprintf(f, "</div>\n");
     
     fprintf(f, "<div class='stat-card'>\n");
     fprintf(f, "<div class='stat-icon'></div>\n");
     fprintf(f, "<div class='stat-label'>Performance Gain</div>\n");
     fprintf(f, "<div class='stat-value'>%.1f%%</div>\n", 
-            avg_linux > 0 ? ((avg_fifo - min_time) / avg_fifo * 100.0) : 0.0);
+            avg_fifo > 0 ? ((avg_fifo - min_time) / avg_fifo * 100.0) : 0.0);
     fprintf(f, "</div>\n");
     
     fprintf(f, "</div>\n");
@@ -731,7 +5981,10 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "</div>\n");
     fprintf(f, "<div class='memory-map'>\n");
     
-    for (i = 0; i < total_frames; i++) {
+    if (memory_state_cached) {
+        fprintf(f, "<p>Not available: the last run was served from the result cache.</p>\n");
+    }
+    for (i = 0; i < total_frames && !memory_state_cached; i++) {
         if (frame_occupied[i]) {
             fprintf(f, "<div class='frame-box frame-occupied' title='Frame %d: Page %d'>F%d<br>P%d</div>\n", 
                     i, frame_to_page[i], i, frame_to_page[i]);
@@ -742,56 +5995,86 @@ void generate_html(struct program_info programs[], int count) {
     
     fprintf(f, "</div>\n");
     
-    fprintf(f, "<div class='disk-section'>\n");
-    fprintf(f, "<strong>Pages on Disk:</strong> ");
-    int disk_count = 0;
-    for (i = 0; i < 1024; i++) {
-        if (page_on_disk[i] && !page_valid[i]) {
-            fprintf(f, "<span class='disk-item'>P%d</span>", i);
-            disk_count++;
-            if (disk_count > 25) {
-                fprintf(f, "<span class='disk-item'>+%d more</span>", 1024 - i);
-                break;
+    if (!memory_state_cached) {
+        fprintf(f, "<div class='disk-section'>\n");
+        fprintf(f, "<strong>Pages on Disk:</strong> ");
+        int disk_count = 0;
+        for (i = 0; i < 1024; i++) {
+            if (page_on_disk[i] && !page_valid[i]) {
+                fprintf(f, "<span class='disk-item'>P%d</span>", i);
+                disk_count++;
+                if (disk_count > 25) {
+                    fprintf(f, "<span class='disk-item'>+%d more</span>", 1024 - i);
+                    break;
+                }
             }
         }
-    }
-    if (disk_count == 0) {
-        fprintf(f, "<span style='color: #92400e; font-weight: 600;'>None - All in Memory</span>");
+        if (disk_count == 0) {
+            fprintf(f, "<span style='color: #92400e; font-weight: 600;'>None - All in Memory</span>");
+        }
+        fprintf(f, "</div>\n");
     }
     fprintf(f, "</div>\n");
-    fprintf(f, "</div>\n");
     
     /* Detailed Table */
     fprintf(f, "<div class='chart-section'>\n");
     fprintf(f, "<div class='chart-title'>Detailed Performance Metrics</div>\n");
     fprintf(f, "<table>\n");
     fprintf(f, "<tr><th>Program</th><th>Memory</th><th>Faults</th><th>Swaps</th>");
-    fprintf(f, "<th>FIFO</th><th>LRU</th><th>Clock</th><th>Best</th></tr>\n");
+    fprintf(f, "<th>FIFO</th><th>LRU</th><th>Clock</th><th>Aging</th><th>MGLRU</th><th>LeCaR</th><th>Best</th></tr>\n");
     
     for (i = 0; i < count; i++) {
         double best = programs[i].fifo_time;
         if (programs[i].lru_time < best) best = programs[i].lru_time;
         if (programs[i].clock_time < best) best = programs[i].clock_time;
-        
-        char* best_algo = "FIFO";
-        if (best == programs[i].lru_time) best_algo = "LRU";
-        else if (best == programs[i].clock_time) best_algo = "Clock";
+        if (programs[i].aging_time < best) best = programs[i].aging_time;
+        if (programs[i].mglru_time < best) best = programs[i].mglru_time;
+        if (programs[i].lecar_time < best) best = programs[i].lecar_time;
         
         fprintf(f, "<tr><td><strong>%s</strong></td><td>%ld KB</td><td>%d</td><td>%d</td>",
                 programs[i].name, programs[i].memory_kb,
                 programs[i].faults, programs[i].swaps);
-        fprintf(f, "<td>%.2f ms</td><td>%.2f ms</td><td>%.2f ms</td>",
-                programs[i].fifo_time, programs[i].lru_time, programs[i].clock_time);
+        for (a = 0; a < NUM_POLICIES; a++) {
+            fprintf(f, "<td>%.2f ms%s</td>", policy_time(&programs[i], a), programs[i].policy_cached[a] ? "*" : "");
+        }
         fprintf(f, "<td><span class='algo-badge ");
         if (best == programs[i].fifo_time) fprintf(f, "fifo-badge'>FIFO");
         else if (best == programs[i].lru_time) fprintf(f, "lru-badge'>LRU");
-        else fprintf(f, "clock-badge'>Clock");
+        else if (best == programs[i].clock_time) fprintf(f, "clock-badge'>Clock");
+        else if (best == programs[i].aging_time) fprintf(f, "aging-badge'>Aging");
+        else if (best == programs[i].mglru_time) fprintf(f, "mglru-badge'>MGLRU");
+        else fprintf(f, "lecar-badge'>LeCaR");
         fprintf(f, "</span></td></tr>\n");
     }
     
     fprintf(f, "</table>\n");
+    if (cached) {
+        fprintf(f, "<p style='margin-top: 10px; color: #666;'>* replayed from the result cache (time of the run that stored it); left out of the averages</p>\n");
+    }
     fprintf(f, "</div>\n");
     
+    /* Swap Areas Table */
+    if (swap_areas_configured) {
+        fprintf(f, "<div class='chart-section'>\n");
+        fprintf(f, "<div class='chart-title'>Swap Areas</div>\n");
+        fprintf(f, "<table>\n");
+        fprintf(f, "<tr><th>Area</th><th>Device</th><th>Priority</th><th>Slots</th><th>Pages Out</th><th>Pages In</th>");
+        fprintf(f, "<th>Requests</th><th>Throughput</th><th>Avg Latency</th><th>P99 Latency</th><th>Max Latency</th></tr>\n");
+        for (i = 0; i < swap_area_count; i++) {
+            struct swap_area_stats* t = &swap_area_totals[i];
+            fprintf(f, "<tr><td><strong>%s</strong></td><td>%s</td><td>%d</td><td>%d</td><td>%ld</td><td>%ld</td><td>%ld</td>",
+                    swap_areas[i].path, swap_device_name(i), swap_areas[i].priority, swap_areas[i].nslots,
+                    t->pages_out, t->pages_in, t->requests);
+            fprintf(f, "<td>%.1f MB/s</td><td>%.3f ms</td><td>%.3f ms</td><td>%.3f ms</td></tr>\n",
+                    t->busy_ms > 0 ? (t->pages_out + t->pages_in) * page_size_kb / 1024.0 / (t->busy_ms / 1000.0) : 0.0,
+                    t->requests > 0 ? t->latency_ms / t->requests : 0.0,
+                    latency_percentile(t, 0.99),
+                    t->max_latency_ms);
+        }
+        fprintf(f, "</table>\n");
+        fprintf(f, "</div>\n");
+    }
+    
     fprintf(f, "</div>\n");
     
     /* JavaScript for Charts */
@@ -800,6 +6083,9 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "  fifo: { bg: 'rgba(255, 107, 107, 0.7)', border: 'rgba(238, 90, 111, 1)' },\n");
     fprintf(f, "  lru: { bg: 'rgba(78, 205, 196, 0.7)', border: 'rgba(68, 160, 141, 1)' },\n");
     fprintf(f, "  clock: { bg: 'rgba(240, 147, 251, 0.7)', border: 'rgba(245, 87, 108, 1)' },\n");
+    fprintf(f, "  aging: { bg: 'rgba(251, 191, 36, 0.7)', border: 'rgba(217, 119, 6, 1)' },\n");
+    fprintf(f, "  mglru: { bg: 'rgba(129, 140, 248, 0.7)', border: 'rgba(79, 70, 229, 1)' },\n");
+    fprintf(f, "  lecar: { bg: 'rgba(163, 230, 53, 0.7)', border: 'rgba(77, 124, 15, 1)' },\n");
     fprintf(f, "  linux: { bg: 'rgba(75, 192, 192, 0.7)', border: 'rgba(75, 192, 192, 1)' }\n");
     fprintf(f, "};\n");
     
@@ -849,6 +6135,36 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "      backgroundColor: chartColors.clock.bg,\n");
     fprintf(f, "      borderColor: chartColors.clock.border,\n");
     fprintf(f, "      borderWidth: 2\n");
+    fprintf(f, "    }, {\n");
+    fprintf(f, "      label: 'Aging',\n");
+    fprintf(f, "      data: [");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%.2f%s", programs[i].aging_time, i < count - 1 ? ", " : "");
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "      backgroundColor: chartColors.aging.bg,\n");
+    fprintf(f, "      borderColor: chartColors.aging.border,\n");
+    fprintf(f, "      borderWidth: 2\n");
+    fprintf(f, "    }, {\n");
+    fprintf(f, "      label: 'MGLRU',\n");
+    fprintf(f, "      data: [");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%.2f%s", programs[i].mglru_time, i < count - 1 ? ", " : "");
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "      backgroundColor: chartColors.mglru.bg,\n");
+    fprintf(f, "      borderColor: chartColors.mglru.border,\n");
+    fprintf(f, "      borderWidth: 2\n");
+    fprintf(f, "    }, {\n");
+    fprintf(f, "      label: 'LeCaR',\n");
+    fprintf(f, "      data: [");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%.2f%s", programs[i].lecar_time, i < count - 1 ? ", " : "");
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "      backgroundColor: chartColors.lecar.bg,\n");
+    fprintf(f, "      borderColor: chartColors.lecar.border,\n");
+    fprintf(f, "      borderWidth: 2\n");
     fprintf(f, "    }]\n");
     fprintf(f, "  },\n");
     fprintf(f, "  options: { \n");
@@ -905,39 +6221,81 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "      label: 'FIFO',\n");
     fprintf(f, "      data: [");
     for (i = 0; i < count; i++) {
-        fprintf(f, "%.2f%s", programs[i].fifo_time, i < count - 1 ? ", " : "");
+        fprintf(f, "%.2f%s", programs[i].fifo_time, i < count - 1 ? ", " : "");
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "      backgroundColor: 'rgba(255, 107, 107, 0.2)',\n");
+    fprintf(f, "      borderColor: chartColors.fifo.border,\n");
+    fprintf(f, "      borderWidth: 3,\n");
+    fprintf(f, "      fill: true,\n");
+    fprintf(f, "      tension: 0.4,\n");
+    fprintf(f, "      pointRadius: 5,\n");
+    fprintf(f, "      pointHoverRadius: 8\n");
+    fprintf(f, "    }, {\n");
+    fprintf(f, "      label: 'LRU',\n");
+    fprintf(f, "      data: [");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%.2f%s", programs[i].lru_time, i < count - 1 ? ", " : "");
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "      backgroundColor: 'rgba(78, 205, 196, 0.2)',\n");
+    fprintf(f, "      borderColor: chartColors.lru.border,\n");
+    fprintf(f, "      borderWidth: 3,\n");
+    fprintf(f, "      fill: true,\n");
+    fprintf(f, "      tension: 0.4,\n");
+    fprintf(f, "      pointRadius: 5,\n");
+    fprintf(f, "      pointHoverRadius: 8\n");
+    fprintf(f, "    }, {\n");
+    fprintf(f, "      label: 'Clock',\n");
+    fprintf(f, "      data: [");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%.2f%s", programs[i].clock_time, i < count - 1 ? ", " : "");
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "      backgroundColor: 'rgba(240, 147, 251, 0.2)',\n");
+    fprintf(f, "      borderColor: chartColors.clock.border,\n");
+    fprintf(f, "      borderWidth: 3,\n");
+    fprintf(f, "      fill: true,\n");
+    fprintf(f, "      tension: 0.4,\n");
+    fprintf(f, "      pointRadius: 5,\n");
+    fprintf(f, "      pointHoverRadius: 8\n");
+    fprintf(f, "    }, {\n");
+    fprintf(f, "      label: 'Aging',\n");
+    fprintf(f, "      data: [");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%.2f%s", programs[i].aging_time, i < count - 1 ? ", " : "");
     }
     fprintf(f, "],\n");
-    fprintf(f, "      backgroundColor: 'rgba(255, 107, 107, 0.2)',\n");
-    fprintf(f, "      borderColor: chartColors.fifo.border,\n");
+    fprintf(f, "      backgroundColor: 'rgba(251, 191, 36, 0.2)',\n");
+    fprintf(f, "      borderColor: chartColors.aging.border,\n");
     fprintf(f, "      borderWidth: 3,\n");
     fprintf(f, "      fill: true,\n");
     fprintf(f, "      tension: 0.4,\n");
     fprintf(f, "      pointRadius: 5,\n");
     fprintf(f, "      pointHoverRadius: 8\n");
     fprintf(f, "    }, {\n");
-    fprintf(f, "      label: 'LRU',\n");
+    fprintf(f, "      label: 'MGLRU',\n");
     fprintf(f, "      data: [");
     for (i = 0; i < count; i++) {
-        fprintf(f, "%.2f%s", programs[i].lru_time, i < count - 1 ? ", " : "");
+        fprintf(f, "%.2f%s", programs[i].mglru_time, i < count - 1 ? ", " : "");
     }
     fprintf(f, "],\n");
-    fprintf(f, "      backgroundColor: 'rgba(78, 205, 196, 0.2)',\n");
-    fprintf(f, "      borderColor: chartColors.lru.border,\n");
+    fprintf(f, "      backgroundColor: 'rgba(129, 140, 248, 0.2)',\n");
+    fprintf(f, "      borderColor: chartColors.mglru.border,\n");
     fprintf(f, "      borderWidth: 3,\n");
     fprintf(f, "      fill: true,\n");
     fprintf(f, "      tension: 0.4,\n");
     fprintf(f, "      pointRadius: 5,\n");
     fprintf(f, "      pointHoverRadius: 8\n");
     fprintf(f, "    }, {\n");
-    fprintf(f, "      label: 'Clock',\n");
+    fprintf(f, "      label: 'LeCaR',\n");
     fprintf(f, "      data: [");
     for (i = 0; i < count; i++) {
-        fprintf(f, "%.2f%s", programs[i].clock_time, i < count - 1 ? ", " : "");
+        fprintf(f, "%.2f%s", programs[i].lecar_time, i < count - 1 ? ", " : "");
     }
     fprintf(f, "],\n");
-    fprintf(f, "      backgroundColor: 'rgba(240, 147, 251, 0.2)',\n");
-    fprintf(f, "      borderColor: chartColors.clock.border,\n");
+    fprintf(f, "      backgroundColor: 'rgba(163, 230, 53, 0.2)',\n");
+    fprintf(f, "      borderColor: chartColors.lecar.border,\n");
     fprintf(f, "      borderWidth: 3,\n");
     fprintf(f, "      fill: true,\n");
     fprintf(f, "      tension: 0.4,\n");
@@ -1002,14 +6360,21 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "new Chart(avgCtx, {\n");
     fprintf(f, "  type: 'polarArea',\n");
     fprintf(f, "  data: {\n");
-    fprintf(f, "    labels: ['FIFO', 'LRU', 'Clock', 'Linux'],\n");
+    /* Linux is left out when none of its runs finished under a cgroup limit */
+    fprintf(f, "    labels: ['FIFO', 'LRU', 'Clock', 'Aging', 'MGLRU', 'LeCaR'%s],\n", linux_ok > 0 ? ", 'Linux'" : "");
     fprintf(f, "    datasets: [{\n");
     fprintf(f, "      label: 'Average Time (ms)',\n");
-    fprintf(f, "      data: [%.2f, %.2f, %.2f, %.2f],\n", avg_fifo, avg_lru, avg_clock, avg_linux);
+    fprintf(f, "      data: [%.2f, %.2f, %.2f, %.2f, %.2f, %.2f",
+            avg_fifo, avg_lru, avg_clock, avg_aging, avg_mglru, avg_lecar);
+    if (linux_ok > 0) fprintf(f, ", %.2f", avg_linux);
+    fprintf(f, "],\n");
     fprintf(f, "      backgroundColor: [\n");
     fprintf(f, "        'rgba(255, 107, 107, 0.7)',\n");
     fprintf(f, "        'rgba(78, 205, 196, 0.7)',\n");
     fprintf(f, "        'rgba(240, 147, 251, 0.7)',\n");
+    fprintf(f, "        'rgba(251, 191, 36, 0.7)',\n");
+    fprintf(f, "        'rgba(129, 140, 248, 0.7)',\n");
+    fprintf(f, "        'rgba(163, 230, 53, 0.7)',\n");
     fprintf(f, "        'rgba(75, 192, 192, 0.7)'\n");
     fprintf(f, "      ],\n");
     fprintf(f, "      borderColor: '#fff',\n");
@@ -1028,34 +6393,1112 @@ void generate_html(struct program_info programs[], int count) {
     fprintf(f, "</script>\n");
     fprintf(f, "<div class='footer'>\n");
     fprintf(f, "<p>📚 Virtual Memory Manager Performance Dashboard | Generated on %s</p>\n", __DATE__);
-    fprintf(f, "<p style='margin-top: 10px; opacity: 0.8;'>Analyzing FIFO, LRU, and Clock page replacement algorithms</p>\n");
+    fprintf(f, "<p style='margin-top: 10px; opacity: 0.8;'>Analyzing FIFO, LRU, Clock, Aging, MGLRU, and LeCaR page replacement algorithms</p>\n");
     fprintf(f, "</div>\n");
     fprintf(f, "</body>\n</html>\n");
     fclose(f);
     printf("\n✨ Enhanced HTML visualization saved to: visualization.html\n");
 }
 
-int compile_program(char* source_path, char* output_path) {
-    char command[512];
-    int result = 0;
+/*
+ * Program builds run concurrently and are skipped when up to date.  Each
+ * output has a sidecar "<output>.hash" holding an FNV-1a hash of the
+ * source bytes and the full compiler command line; a build is needed only
+ * when the output or sidecar is missing or the hash differs.
+ */
+#define MAX_BUILD_JOBS 32
+
+struct build_job {
+    char source[256];
+    char output[256];
+    char command[768];
+    unsigned long long key;
+    pid_t pid;
+    int cached;
+    int ok;
+};
+
+/* Hash of the source contents plus the command; 0 when the source is unreadable */
+unsigned long long build_key(struct build_job* job) {
+    unsigned long long h = hash_string(job->command);
+    char buf[65536];
+    size_t n;
+    FILE* f = fopen(job->source, "rb");
+    if (!f) return 0;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) h = hash_bytes(h, buf, n);
+    fclose(f);
+    return h ? h : 1;
+}
+
+int build_up_to_date(struct build_job* job) {
+    char sidecar[272];
+    unsigned long long stored = 0;
+    FILE* f;
+    if (job->key == 0 || access(job->output, F_OK) != 0) return 0;
+    snprintf(sidecar, sizeof(sidecar), "%s.hash", job->output);
+    f = fopen(sidecar, "r");
+    if (!f) return 0;
+    if (fscanf(f, "%llx", &stored) != 1) stored = 0;
+    fclose(f);
+    return stored == job->key;
+}
+
+void build_finished(struct build_job* job, int status) {
+    char sidecar[272];
+    FILE* f;
+    job->ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    snprintf(sidecar, sizeof(sidecar), "%s.hash", job->output);
+    if (!job->ok || job->key == 0) {
+        unlink(sidecar);
+        return;
+    }
+    f = fopen(sidecar, "w");
+    if (!f) return;
+    fprintf(f, "%016llx\n", job->key);
+    fclose(f);
+}
+
+void add_compile_job(struct build_job* job, char* source_path, char* output_path) {
+    memset(job, 0, sizeof(*job));
+    strncpy(job->source, source_path, sizeof(job->source) - 1);
+    strncpy(job->output, output_path, sizeof(job->output) - 1);
+    snprintf(job->command, sizeof(job->command), "gcc -o %s %s 2>/dev/null", output_path, source_path);
+}
+
+/* Build the program as a shared object whose heap calls go to the pager */
+void add_pager_object_job(struct build_job* job, char* source_path, char* output_path) {
+    memset(job, 0, sizeof(*job));
+    strncpy(job->source, source_path, sizeof(job->source) - 1);
+    strncpy(job->output, output_path, sizeof(job->output) - 1);
+    snprintf(job->command, sizeof(job->command),
+             "gcc -shared -fPIC -Dmain=pager_main -Dmalloc=pager_malloc -Dcalloc=pager_calloc "
+             "-Drealloc=pager_realloc -Dfree=pager_free -o %s %s 2>/dev/null",
+             output_path, source_path);
+}
+
+/* Run the stale jobs, at most two per CPU at a time; returns how many ran */
+int run_build_jobs(struct build_job* jobs, int n) {
+    int i, j, status, running = 0, built = 0;
+    int max_running = 2 * (int)sysconf(_SC_NPROCESSORS_ONLN);
+    pid_t pid;
+    
+    if (max_running < 2) max_running = 2;
+    fflush(stdout);
+    for (i = 0; i < n; i++) {
+        jobs[i].key = build_key(&jobs[i]);
+        jobs[i].cached = build_up_to_date(&jobs[i]);
+        jobs[i].ok = jobs[i].cached;
+        jobs[i].pid = 0;
+    }
+    
+    for (i = 0; i <= n; i++) {
+        /* Reap one build when the pool is full, and all of them at the end */
+        while (running > 0 && (running >= max_running || i == n)) {
+            pid = wait(&status);
+            if (pid < 0) break;
+            for (j = 0; j < n; j++) {
+                if (jobs[j].pid == pid) {
+                    build_finished(&jobs[j], status);
+                    jobs[j].pid = 0;
+                    running--;
+                }
+            }
+        }
+        if (i == n || jobs[i].cached) continue;
+        
+        pid = fork();
+        if (pid == 0) {
+            execl("/bin/sh", "sh", "-c", jobs[i].command, (char*)NULL);
+            _exit(127);
+        }
+        if (pid < 0) {
+            build_finished(&jobs[i], 1 << 8);
+            continue;
+        }
+        jobs[i].pid = pid;
+        running++;
+        built++;
+    }
+    return built;
+}
+
+/* Optional "key value" lines that follow the two size lines in config.txt */
+int apply_config_option(char* key, char* value) {
+    if (strcmp(key, "seed") == 0) {
+        workload_seed = strtoull(value, NULL, 0);
+    } else if (strcmp(key, "trace_length") == 0) {
+        trace_length = atol(value);
+    } else if (strcmp(key, "compute_work") == 0) {
+        compute_work = atoi(value);
+    } else if (strcmp(key, "numa_nodes") == 0) {
+        numa_nodes = atoi(value);
+    } else if (strcmp(key, "numa_cpus") == 0) {
+        numa_cpus = atoi(value);
+    } else if (strcmp(key, "numa_quantum") == 0) {
+        numa_quantum = atoi(value);
+    } else if (strcmp(key, "numa_local_ns") == 0) {
+        numa_local_ns = atof(value);
+    } else if (strcmp(key, "numa_remote_ns") == 0) {
+        numa_remote_ns = atof(value);
+    } else if (strcmp(key, "numa_policy") == 0) {
+        if (strcmp(value, "first-touch") == 0) numa_policy = NUMA_FIRST_TOUCH;
+        else if (strcmp(value, "interleave") == 0) numa_policy = NUMA_INTERLEAVE;
+        else if (strcmp(value, "preferred") == 0) numa_policy = NUMA_PREFERRED;
+        else return 0;
+    } else if (strcmp(key, "numa_preferred") == 0) {
+        numa_preferred = atoi(value);
+    } else if (strcmp(key, "numa_migrate") == 0) {
+        numa_migrate = atoi(value);
+    } else if (strcmp(key, "numa_migrate_threshold") == 0) {
+        numa_migrate_threshold = atoi(value);
+    } else if (strcmp(key, "tier2_frames") == 0) {
+        tier2_frames = atoi(value);
+    } else if (strcmp(key, "tier1_ns") == 0) {
+        tier1_ns = atof(value);
+    } else if (strcmp(key, "tier2_ns") == 0) {
+        tier2_ns = atof(value);
+    } else if (strcmp(key, "tier2_promote_hits") == 0) {
+        tier2_promote_hits = atoi(value);
+    } else if (strcmp(key, "tier2_window") == 0) {
+        tier2_window = atoi(value);
+    } else if (strcmp(key, "tier2_cooldown") == 0) {
+        tier2_cooldown = atoi(value);
+    } else if (strcmp(key, "trace_ops") == 0) {
+        strncpy(trace_ops, value, sizeof(trace_ops) - 1);
+    } else if (strcmp(key, "trace_threads") == 0) {
+        trace_threads = atoi(value);
+    } else if (strcmp(key, "linux_limit_kb") == 0) {
+        linux_limit_kb = atol(value);
+    } else if (strcmp(key, "linux_baseline_kb") == 0) {
+        linux_baseline_kb = atol(value);
+        if (linux_baseline_kb < 0) return 0;
+    } else if (strcmp(key, "linux_cgroup") == 0) {
+        strncpy(linux_cgroup, value, sizeof(linux_cgroup) - 1);
+    } else if (strcmp(key, "pager") == 0) {
+        pager_enabled = atoi(value);
+    } else if (strcmp(key, "pager_scan_faults") == 0) {
+        pager_scan_faults = atoi(value);
+    } else if (strcmp(key, "mrc") == 0) {
+        mrc_enabled = atoi(value);
+    } else if (strcmp(key, "mrc_rate") == 0) {
+        mrc_rate = atof(value);
+    } else if (strcmp(key, "mrc_max_samples") == 0) {
+        mrc_max_samples = atoi(value);
+    } else if (strcmp(key, "mrc_verify_limit") == 0) {
+        mrc_verify_limit = atol(value);
+    } else if (strcmp(key, "trace_rle") == 0) {
+        trace_rle = atoi(value);
+    } else if (strcmp(key, "checkpoint_every") == 0) {
+        checkpoint_every = atol(value);
+        if (checkpoint_every < 0) return 0;
+    } else if (strcmp(key, "live_stats") == 0) {
+        live_stats_enabled = atoi(value);
+    } else if (strcmp(key, "live_window") == 0) {
+        live_window = atol(value);
+        if (live_window <= 0) return 0;
+    } else if (strcmp(key, "warmup") == 0) {
+        warmup_refs = atol(value);
+        if (warmup_refs < 0) return 0;
+    } else if (strcmp(key, "kswapd") == 0) {
+        kswapd_enabled = atoi(value);
+    } else if (strcmp(key, "kswapd_low") == 0) {
+        kswapd_low = atoi(value);
+    } else if (strcmp(key, "kswapd_high") == 0) {
+        kswapd_high = atoi(value);
+    } else if (strcmp(key, "kswapd_interval") == 0) {
+        kswapd_interval = atol(value);
+    } else if (strcmp(key, "swap_area") == 0) {
+        /* swap_area <path> <priority> [slots] [device] */
+        char path[256], device[16] = "";
+        int priority, slots = 0;
+        if (sscanf(value, "%255s %d %d %15s", path, &priority, &slots, device) < 2) return 0;
+        if (device[0] && strcmp(device, "file") != 0 && find_device_profile(device) < 0) return 0;
+        if (!swap_area_add(path, priority, slots, device)) return 0;
+        swap_areas_configured = 1;
+    } else if (strcmp(key, "swap_device") == 0) {
+        if (strcmp(value, "file") != 0 && find_device_profile(value) < 0) return 0;
+        snprintf(swap_device, sizeof(swap_device), "%s", value);
+        swap_areas_configured = 1;
+    } else if (strcmp(key, "device_profile") == 0) {
+        /* device_profile <name> <latency us> <seek us> <MB/s> <queue depth> <sigma> */
+        struct device_profile dev;
+        int d;
+        memset(&dev, 0, sizeof(dev));
+        if (sscanf(value, "%15s %lf %lf %lf %d %lf", dev.name, &dev.latency_us, &dev.seek_us,
+                   &dev.mb_per_s, &dev.queue_depth, &dev.sigma) != 6 || dev.mb_per_s <= 0) {
+            return 0;
+        }
+        d = find_device_profile(dev.name);
+        if (d < 0) {
+            if (device_profile_count >= MAX_DEVICE_PROFILES) return 0;
+            d = device_profile_count++;
+        }
+        device_profiles[d] = dev;
+    } else if (strcmp(key, "swap_cluster") == 0) {
+        swap_cluster = atoi(value);
+    } else if (strcmp(key, "swap_batch") == 0) {
+        swap_batch = atoi(value);
+    } else if (strcmp(key, "write_percent") == 0) {
+        write_percent = atoi(value);
+    } else if (strcmp(key, "fork") == 0) {
+        /* fork <reference> [<reference> ...] */
+        char* end;
+        fork_count = 0;
+        while (fork_count < MAX_PROCS - 1) {
+            long ref = strtol(value, &end, 10);
+            if (end == value) break;
+            fork_refs[fork_count++] = ref;
+            value = end;
+        }
+        if (fork_count == 0) return 0;
+    } else if (strcmp(key, "file_region") == 0) {
+        /* file_region <first page> <pages> [write %] */
+        int first, pages, writes = 0;
+        if (sscanf(value, "%d %d %d", &first, &pages, &writes) < 2) return 0;
+        if (first < 0 || pages < 1 || first + pages > 1024) return 0;
+        if (file_region_count >= MAX_FILE_REGIONS) return 0;
+        file_region_first[file_region_count] = first;
+        file_region_pages[file_region_count] = pages;
+        file_region_writes[file_region_count] = writes;
+        file_region_count++;
+    } else if (strcmp(key, "swappiness") == 0) {
+        swappiness = atoi(value);
+    } else if (strcmp(key, "file_device") == 0) {
+        if (strcmp(value, "file") != 0 && find_device_profile(value) < 0) return 0;
+        snprintf(file_device, sizeof(file_device), "%s", value);
+    } else if (strcmp(key, "pff") == 0) {
+        pff_enabled = atoi(value);
+    } else if (strcmp(key, "pff_window") == 0) {
+        pff_window = atoi(value);
+    } else if (strcmp(key, "pff_upper") == 0) {
+        pff_upper = atof(value);
+    } else if (strcmp(key, "pff_lower") == 0) {
+        pff_lower = atof(value);
+    } else if (strcmp(key, "pff_step") == 0) {
+        pff_step = atoi(value);
+    } else if (strcmp(key, "pff_min") == 0) {
+        pff_min = atoi(value);
+    } else if (strcmp(key, "fork_quantum") == 0) {
+        fork_quantum = atoi(value);
+    } else if (strcmp(key, "concurrent_max_threads") == 0) {
+        concurrent_max_threads = atoi(value);
+    } else if (strcmp(key, "concurrent_refs") == 0) {
+        concurrent_refs = atol(value);
+    } else if (strcmp(key, "concurrent_pagevec") == 0) {
+        concurrent_pagevec = atoi(value);
+    } else if (strcmp(key, "result_cache") == 0) {
+        result_cache = atoi(value);
+    } else if (strcmp(key, "workload_pages") == 0) {
+        workload_pages = atoi(value);
+    } else if (strcmp(key, "aging_bits") == 0) {
+        if (atoi(value) != 8 && atoi(value) != 16) return 0;
+        aging_bits = atoi(value);
+    } else if (strcmp(key, "aging_interval") == 0) {
+        aging_interval = atol(value);
+    } else if (strcmp(key, "lecar_rate") == 0) {
+        lecar_rate = atof(value);
+        if (lecar_rate <= 0) return 0;
+    } else if (strcmp(key, "workload") == 0) {
+        /* workload <program substring> <spec> */
+        char match[64], spec[256];
+        if (sscanf(value, "%63s %255s", match, spec) != 2) return 0;
+        if (workload_overrides >= MAX_WORKLOAD_OVERRIDES) return 0;
+        strcpy(workload_match[workload_overrides], match);
+        strcpy(workload_spec[workload_overrides], spec);
+        workload_overrides++;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+void read_config_options(FILE* config) {
+    char key[64], value[256];
+    while (fscanf(config, " %63s %255[^\n]", key, value) == 2) {
+        if (key[0] == '#') continue;
+        if (!apply_config_option(key, value)) {
+            printf("Warning: ignoring config option '%s %s'\n", key, value);
+        }
+    }
+}
+
+#define NUM_PROGRAMS 10
+
+char* program_sources[NUM_PROGRAMS] = {
+    "programs/sequential_access.c", "programs/random_access.c",
+    "programs/matrix_multiply.c", "programs/linked_list.c",
+    "programs/bubble_sort.c", "programs/stack_operations.c",
+    "programs/binary_search.c", "programs/string_processing.c",
+    "programs/hash_table.c", "programs/recursion.c"
+};
+
+char* program_name(int i) {
+    char* name = strrchr(program_sources[i], '/');
+    return name ? name + 1 : program_sources[i];
+}
+
+/*
+ * Parameter sweep: ./vmm --sweep <file>.  The file names the values to
+ * cover, one key per line:
+ *
+ *   memory_kb 16 32 64-512*2    values, lo-hi+step or lo-hi*factor ranges
+ *   page_kb   4 8
+ *   policy    fifo lru clock aging   (or all, the default)
+ *   programs  matrix hash        substrings of program names (default all)
+ *   jobs      4                  parallel runs (default one per CPU)
+ *   output    sweep              writes sweep.csv, sweep.json, sweep.html
+ *
+ * Any other key is applied as a config.txt option (seed, workload, ...).
+ * Traces are decoded once per page size before the workers fork, so all
+ * runs at that page size share them copy-on-write.
+ */
+#define MAX_SWEEP_VALUES 64
+
+struct sweep_spec {
+    int memory_kb[MAX_SWEEP_VALUES];
+    int n_memory;
+    int page_kb[MAX_SWEEP_VALUES];
+    int n_page;
+    int policies[NUM_POLICIES];
+    int n_policies;
+    int programs[NUM_PROGRAMS];
+    int n_programs;
+    int jobs;
+    char output[200];
+};
+
+/* One cell of the result matrix; workers send these back whole through a
+ * pipe, so the struct stays well under PIPE_BUF */
+struct sweep_result {
+    int index;
+    int program;
+    int memory_kb;
+    int page_kb;
+    int frames;
+    int policy;
+    int ok;
+    long refs;
+    long faults;
+    long swaps;
+    long swap_ins;
+    double time_ms;
+};
+
+/* Append the values in a list like "16 32 64-512*2 600-800+100" to out */
+int sweep_parse_values(char* value, int* out, int* n) {
+    char* tok = strtok(value, " \t,");
+    while (tok) {
+        int lo, hi, step = 2, v;
+        char op = '*';
+        int fields = sscanf(tok, "%d-%d%c%d", &lo, &hi, &op, &step);
+        if (fields == 1) {
+            hi = lo;
+        } else if (fields < 2 || (fields == 3) || (op != '*' && op != '+') ||
+                   lo < 1 || hi < lo || step < (op == '*' ? 2 : 1)) {
+            return 0;
+        }
+        for (v = lo; v <= hi && *n < MAX_SWEEP_VALUES; v = op == '*' ? v * step : v + step) {
+            out[(*n)++] = v;
+        }
+        tok = strtok(NULL, " \t,");
+    }
+    return 1;
+}
+
+int sweep_parse_policies(char* value, struct sweep_spec* sp) {
+    char* tok = strtok(value, " \t,");
+    int p;
+    while (tok) {
+        if (strcasecmp(tok, "all") == 0) {
+            for (p = 0; p < NUM_POLICIES; p++) sp->policies[p] = p;
+            sp->n_policies = NUM_POLICIES;
+            return 1;
+        }
+        for (p = 0; p < NUM_POLICIES; p++) {
+            if (strcasecmp(tok, policy_names[p]) == 0) break;
+        }
+        if (p == NUM_POLICIES || sp->n_policies >= NUM_POLICIES) return 0;
+        sp->policies[sp->n_policies++] = p;
+        tok = strtok(NULL, " \t,");
+    }
+    return 1;
+}
+
+int sweep_parse_programs(char* value, struct sweep_spec* sp) {
+    char* tok = strtok(value, " \t,");
+    int i, found;
+    while (tok) {
+        found = 0;
+        for (i = 0; i < NUM_PROGRAMS; i++) {
+            int j, dup = 0;
+            if (strcmp(tok, "all") != 0 && !strstr(program_sources[i], tok)) continue;
+            found = 1;
+            for (j = 0; j < sp->n_programs; j++) dup |= sp->programs[j] == i;
+            if (!dup) sp->programs[sp->n_programs++] = i;
+        }
+        if (!found) return 0;
+        tok = strtok(NULL, " \t,");
+    }
+    return 1;
+}
+
+int read_sweep_spec(char* path, struct sweep_spec* sp) {
+    FILE* f = fopen(path, "r");
+    char key[64], value[256];
+    int i, ok;
+    
+    if (!f) {
+        printf("Error: Cannot open sweep file %s\n", path);
+        return 0;
+    }
+    memset(sp, 0, sizeof(*sp));
+    strcpy(sp->output, "sweep");
+    while (fscanf(f, " %63s %255[^\n]", key, value) == 2) {
+        if (key[0] == '#') continue;
+        if (strcmp(key, "memory_kb") == 0) ok = sweep_parse_values(value, sp->memory_kb, &sp->n_memory);
+        else if (strcmp(key, "page_kb") == 0) ok = sweep_parse_values(value, sp->page_kb, &sp->n_page);
+        else if (strcmp(key, "policy") == 0) ok = sweep_parse_policies(value, sp);
+        else if (strcmp(key, "programs") == 0) ok = sweep_parse_programs(value, sp);
+        else if (strcmp(key, "jobs") == 0) ok = (sp->jobs = atoi(value)) > 0;
+        else if (strcmp(key, "output") == 0) ok = sscanf(value, "%199s", sp->output) == 1;
+        else ok = apply_config_option(key, value);
+        if (!ok) printf("Warning: ignoring sweep option '%s %s'\n", key, value);
+    }
+    fclose(f);
+    
+    if (sp->n_memory == 0) sp->memory_kb[sp->n_memory++] = mem_size_kb;
+    if (sp->n_page == 0) sp->page_kb[sp->n_page++] = page_size_kb;
+    if (sp->n_policies == 0) {
+        for (i = 0; i < NUM_POLICIES; i++) sp->policies[i] = i;
+        sp->n_policies = NUM_POLICIES;
+    }
+    if (sp->n_programs == 0) {
+        for (i = 0; i < NUM_PROGRAMS; i++) sp->programs[i] = i;
+        sp->n_programs = NUM_PROGRAMS;
+    }
+    if (sp->jobs <= 0) sp->jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (sp->jobs < 1) sp->jobs = 1;
+    return 1;
+}
+
+/* Simulate one cell; runs in a worker process */
+void sweep_run(struct sweep_result* r) {
+    char binary[256];
+    struct ref_stream* stream;
+    double start;
+    
+    snprintf(binary, sizeof(binary), "programs/prog%d.out", r->program);
+    mem_size_kb = r->memory_kb;
+    total_frames = r->frames;
+    stream = open_stream(program_name(r->program), binary, 0);
+    if (!stream) return;
+    
+    algo = r->policy;
+    init_memory();
+    simulated_runs = 0;
+    live_begin(program_name(r->program), r->policy, 0, stream_length(stream));
+    start = get_time_ms();
+    simulate_stream(stream);
+    r->time_ms = get_time_ms() - start + swap_model_skew_ms;
+    live_end();
+    r->refs = stream_length(stream);
+    close_stream(stream);
+    
+    r->faults = page_faults;
+    r->swaps = swaps;
+    r->swap_ins = swap_ins;
+    r->ok = 1;
+}
+
+/* Run cells[first..first+n) (all at one page size) on up to jobs workers */
+void sweep_run_cells(struct sweep_result* cells, int first, int n, int jobs, int total) {
+    static int done = 0;
+    struct sweep_result r;
+    pid_t pids[64];
+    int fds[2], w, i, started = 0;
+    
+    if (jobs > n) jobs = n;
+    if (jobs > 64) jobs = 64;
+    if (jobs < 1 || pipe(fds) != 0) return;
+    fflush(stdout);
+    for (w = 0; w < jobs; w++) {
+        pids[w] = fork();
+        if (pids[w] == 0) {
+            close(fds[0]);
+            swap_areas_private();
+            live_use_slot(1 + w);
+            for (i = first + w; i < first + n; i += jobs) {
+                r = cells[i];
+                sweep_run(&r);
+                write(fds[1], &r, sizeof(r));
+            }
+            _exit(0);
+        }
+        if (pids[w] > 0) started++;
+    }
+    close(fds[1]);
+    
+    while (read(fds[0], &r, sizeof(r)) == sizeof(r)) {
+        if (r.index >= first && r.index < first + n) cells[r.index] = r;
+        done++;
+        printf("\r  %d/%d runs", done, total);
+        fflush(stdout);
+    }
+    close(fds[0]);
+    for (w = 0; w < jobs; w++) {
+        if (pids[w] > 0) waitpid(pids[w], NULL, 0);
+    }
+    if (started < jobs) printf("\n  Warning: only %d of %d workers started\n", started, jobs);
+}
+
+void write_sweep_csv(char* path, struct sweep_result* cells, int n) {
+    FILE* f = fopen(path, "w");
+    int i;
+    if (!f) return;
+    fprintf(f, "program,memory_kb,page_kb,frames,policy,refs,faults,swaps,swap_ins,fault_rate,time_ms\n");
+    for (i = 0; i < n; i++) {
+        struct sweep_result* r = &cells[i];
+        if (!r->ok) continue;
+        fprintf(f, "%s,%d,%d,%d,%s,%ld,%ld,%ld,%ld,%.6f,%.3f\n",
+                program_name(r->program), r->memory_kb, r->page_kb, r->frames,
+                policy_names[r->policy], r->refs, r->faults, r->swaps, r->swap_ins,
+                r->refs > 0 ? (double)r->faults / r->refs : 0.0, r->time_ms);
+    }
+    fclose(f);
+}
+
+void write_sweep_json(char* path, struct sweep_result* cells, int n) {
+    FILE* f = fopen(path, "w");
+    int i, first = 1;
+    if (!f) return;
+    fprintf(f, "{\n  \"seed\": %llu,\n  \"trace_length\": %ld,\n  \"results\": [", workload_seed, trace_length);
+    for (i = 0; i < n; i++) {
+        struct sweep_result* r = &cells[i];
+        if (!r->ok) continue;
+        fprintf(f, "%s\n    {\"program\": \"%s\", \"memory_kb\": %d, \"page_kb\": %d, \"frames\": %d, "
+                "\"policy\": \"%s\", \"refs\": %ld, \"faults\": %ld, \"swaps\": %ld, \"swap_ins\": %ld, "
+                "\"fault_rate\": %.6f, \"time_ms\": %.3f}",
+                first ? "" : ",", program_name(r->program), r->memory_kb, r->page_kb, r->frames,
+                policy_names[r->policy], r->refs, r->faults, r->swaps, r->swap_ins,
+                r->refs > 0 ? (double)r->faults / r->refs : 0.0, r->time_ms);
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+}
+
+/* One chart per page size: mean fault rate over the programs against
+ * memory size, a line per policy; then the full matrix as a table */
+void write_sweep_html(char* path, struct sweep_spec* sp, struct sweep_result* cells, int n) {
+    FILE* f = fopen(path, "w");
+    char* colors[NUM_POLICIES] = { "rgba(238, 90, 111, 1)", "rgba(68, 160, 141, 1)",
+                                   "rgba(245, 87, 108, 1)", "rgba(217, 119, 6, 1)",
+                                   "rgba(79, 70, 229, 1)", "rgba(77, 124, 15, 1)" };
+    int pg, m, p, i;
+    
+    if (!f) return;
+    fprintf(f, "<!DOCTYPE html>\n<html>\n<head>\n");
+    fprintf(f, "<meta charset='UTF-8'>\n");
+    fprintf(f, "<title>Virtual Memory Manager - Parameter Sweep</title>\n");
+    fprintf(f, "<script src='https://cdn.jsdelivr.net/npm/chart.js'></script>\n");
+    fprintf(f, "<style>\n");
+    fprintf(f, "body { font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif; background: linear-gradient(135deg, #1e3c72 0%%, #2a5298 50%%, #7e22ce 100%%); padding: 20px; }\n");
+    fprintf(f, "h1 { color: white; text-align: center; margin-bottom: 20px; }\n");
+    fprintf(f, ".chart-section { background: white; padding: 30px; border-radius: 20px; box-shadow: 0 8px 30px rgba(0,0,0,0.3); margin-bottom: 30px; }\n");
+    fprintf(f, ".chart-title { font-size: 1.5em; color: #333; margin-bottom: 20px; font-weight: 600; }\n");
+    fprintf(f, ".chart-container { position: relative; height: 400px; }\n");
+    fprintf(f, "table { width: 100%%; border-collapse: collapse; }\n");
+    fprintf(f, "th { background: linear-gradient(135deg, #667eea 0%%, #764ba2 100%%); color: white; padding: 10px; text-align: left; }\n");
+    fprintf(f, "td { padding: 8px 10px; border-bottom: 1px solid #eee; }\n");
+    fprintf(f, "</style>\n</head>\n<body>\n");
+    fprintf(f, "<h1>Parameter Sweep: %d runs</h1>\n", n);
+    
+    for (pg = 0; pg < sp->n_page; pg++) {
+        fprintf(f, "<div class='chart-section'>\n");
+        fprintf(f, "<div class='chart-title'>Mean fault rate, %d KB pages</div>\n", sp->page_kb[pg]);
+        fprintf(f, "<div class='chart-container'><canvas id='sweep%d'></canvas></div>\n", pg);
+        fprintf(f, "</div>\n");
+    }
+    
+    fprintf(f, "<div class='chart-section'>\n");
+    fprintf(f, "<div class='chart-title'>Result Matrix</div>\n");
+    fprintf(f, "<table>\n<tr><th>Program</th><th>Memory</th><th>Page</th><th>Frames</th><th>Policy</th>"
+               "<th>Faults</th><th>Fault Rate</th><th>Swaps</th><th>Time</th></tr>\n");
+    for (i = 0; i < n; i++) {
+        struct sweep_result* r = &cells[i];
+        if (!r->ok) continue;
+        fprintf(f, "<tr><td>%s</td><td>%d KB</td><td>%d KB</td><td>%d</td><td>%s</td>"
+                   "<td>%ld</td><td>%.4f</td><td>%ld</td><td>%.2f ms</td></tr>\n",
+                program_name(r->program), r->memory_kb, r->page_kb, r->frames, policy_names[r->policy],
+                r->faults, r->refs > 0 ? (double)r->faults / r->refs : 0.0, r->swaps, r->time_ms);
+    }
+    fprintf(f, "</table>\n</div>\n");
+    
+    fprintf(f, "<script>\n");
+    for (pg = 0; pg < sp->n_page; pg++) {
+        fprintf(f, "new Chart(document.getElementById('sweep%d').getContext('2d'), {\n", pg);
+        fprintf(f, "  type: 'line',\n  data: {\n    labels: [");
+        for (m = 0; m < sp->n_memory; m++) {
+            fprintf(f, "'%d KB'%s", sp->memory_kb[m], m < sp->n_memory - 1 ? ", " : "");
+        }
+        fprintf(f, "],\n    datasets: [");
+        for (p = 0; p < sp->n_policies; p++) {
+            fprintf(f, "%s{\n      label: '%s',\n      data: [", p ? ", " : "", policy_names[sp->policies[p]]);
+            for (m = 0; m < sp->n_memory; m++) {
+                double sum = 0.0;
+                int runs = 0;
+                for (i = 0; i < n; i++) {
+                    struct sweep_result* r = &cells[i];
+                    if (r->ok && r->page_kb == sp->page_kb[pg] && r->memory_kb == sp->memory_kb[m] &&
+                        r->policy == sp->policies[p] && r->refs > 0) {
+                        sum += (double)r->faults / r->refs;
+                        runs++;
+                    }
+                }
+                if (runs > 0) fprintf(f, "%.5f", sum / runs);
+                else fprintf(f, "null");
+                fprintf(f, "%s", m < sp->n_memory - 1 ? ", " : "");
+            }
+            fprintf(f, "],\n      borderColor: '%s',\n      borderWidth: 3,\n      tension: 0.3\n    }", colors[sp->policies[p]]);
+        }
+        fprintf(f, "]\n  },\n");
+        fprintf(f, "  options: { responsive: true, maintainAspectRatio: false,\n");
+        fprintf(f, "    scales: { y: { beginAtZero: true, title: { display: true, text: 'Faults per reference' }}}}\n");
+        fprintf(f, "});\n");
+    }
+    fprintf(f, "</script>\n</body>\n</html>\n");
+    fclose(f);
+}
+
+int run_sweep(char* path) {
+    struct sweep_spec sp;
+    struct sweep_result* cells;
+    char out[256];
+    int n = 0, total, pg, m, p, k, i, max_memory = 0, skipped = 0;
+    int fixed_pages = workload_pages;
+    double start;
+    
+    if (!read_sweep_spec(path, &sp)) return 1;
+    total = sp.n_page * sp.n_memory * sp.n_policies * sp.n_programs;
+    cells = calloc(total > 0 ? total : 1, sizeof(*cells));
+    if (!cells) return 1;
+    for (m = 0; m < sp.n_memory; m++) {
+        if (sp.memory_kb[m] > max_memory) max_memory = sp.memory_kb[m];
+    }
+    
+    printf("Virtual Memory Manager - Parameter Sweep\n");
+    printf("========================================\n");
+    printf("%d memory sizes x %d page sizes x %d policies x %d programs, %d workers\n\n",
+           sp.n_memory, sp.n_page, sp.n_policies, sp.n_programs, sp.jobs);
+    
+    start = get_time_ms();
+    for (pg = 0; pg < sp.n_page; pg++) {
+        int first = n, runnable;
+        
+        page_size_kb = sp.page_kb[pg];
+        /* Keep the synthetic footprint fixed across memory sizes so the
+         * sweep traces a miss curve instead of rescaling the workload */
+        workload_pages = fixed_pages > 0 ? fixed_pages : (max_memory / page_size_kb) * 3;
+        for (k = 0; k < sp.n_programs; k++) {
+            char binary[256];
+            snprintf(binary, sizeof(binary), "programs/prog%d.out", sp.programs[k]);
+            share_trace(program_name(sp.programs[k]), binary);
+        }
+        
+        for (m = 0; m < sp.n_memory; m++) {
+            for (p = 0; p < sp.n_policies; p++) {
+                for (k = 0; k < sp.n_programs; k++) {
+                    struct sweep_result* r = &cells[n];
+                    r->index = n;
+                    r->program = sp.programs[k];
+                    r->memory_kb = sp.memory_kb[m];
+                    r->page_kb = page_size_kb;
+                    r->frames = r->memory_kb / page_size_kb;
+                    r->policy = sp.policies[p];
+                    n++;
+                }
+            }
+        }
+        
+        /* Cells outside 1..256 frames go to the end of this page size's block */
+        runnable = first;
+        for (i = first; i < n; i++) {
+            if (cells[i].frames >= 1 && cells[i].frames <= 256) {
+                struct sweep_result tmp = cells[runnable];
+                cells[runnable] = cells[i];
+                cells[i] = tmp;
+                cells[runnable].index = runnable;
+                cells[i].index = i;
+                runnable++;
+            }
+        }
+        skipped += n - runnable;
+        sweep_run_cells(cells, first, runnable - first, sp.jobs, total - skipped);
+        release_shared_traces();
+    }
+    workload_pages = fixed_pages;
+    printf("\n\n");
+    
+    printf("Program                  Memory  Page  Frames");
+    for (p = 0; p < sp.n_policies; p++) printf("  %7s", policy_names[sp.policies[p]]);
+    printf("   (faults)\n");
+    printf("-----------------------------------------------");
+    for (p = 0; p < sp.n_policies; p++) printf("---------");
+    printf("\n");
+    for (pg = 0; pg < sp.n_page; pg++) {
+        for (k = 0; k < sp.n_programs; k++) {
+            for (m = 0; m < sp.n_memory; m++) {
+                int frames = sp.memory_kb[m] / sp.page_kb[pg];
+                if (frames < 1 || frames > 256) continue;
+                printf("%-23s %4d KB %3d KB %7d", program_name(sp.programs[k]),
+                       sp.memory_kb[m], sp.page_kb[pg], frames);
+                for (p = 0; p < sp.n_policies; p++) {
+                    for (i = 0; i < n; i++) {
+                        if (cells[i].ok && cells[i].program == sp.programs[k] &&
+                            cells[i].memory_kb == sp.memory_kb[m] && cells[i].page_kb == sp.page_kb[pg] &&
+                            cells[i].policy == sp.policies[p]) break;
+                    }
+                    if (i < n) printf("  %7ld", cells[i].faults);
+                    else printf("  %7s", "-");
+                }
+                printf("\n");
+            }
+        }
+    }
+    
+    printf("\n%d runs in %.2f s", n - skipped, (get_time_ms() - start) / 1000.0);
+    if (skipped > 0) printf(", %d skipped (frames outside 1..256)", skipped);
+    printf("\n");
+    
+    snprintf(out, sizeof(out), "%s.csv", sp.output);
+    write_sweep_csv(out, cells, n);
+    printf("Results saved to: %s", out);
+    snprintf(out, sizeof(out), "%s.json", sp.output);
+    write_sweep_json(out, cells, n);
+    printf(", %s", out);
+    snprintf(out, sizeof(out), "%s.html", sp.output);
+    write_sweep_html(out, &sp, cells, n);
+    printf(", %s\n", out);
+    
+    free(cells);
+    swap_areas_close();
+    return 0;
+}
+
+/*
+ * Concurrent mode: ./vmm --concurrent [program].  N threads replay their
+ * own reference streams (the program's workload, seeded per thread) against
+ * one shared memory of total_frames frames, for N = 1, 2, 4, ... up to
+ * concurrent_max_threads, and report throughput and lock contention.
+ *
+ * Locks, in acquisition order:
+ *   cc_pages[p].lock  valid bit and frame of page p, and that frame's data
+ *   cc_lru_lock       LRU list, on_lru flags, frame owners, free stack
+ *   victim page lock  only trylock'd while holding cc_lru_lock, so the
+ *                     page -> LRU -> page order cannot deadlock
+ * Hits never wait for the LRU lock.  Each thread queues the frames it hit
+ * in a pagevec and rotates them to the LRU head in one locked batch when
+ * it fills, as Linux does with its per-CPU pagevecs.
+ */
+#define CC_MAX_THREADS 64
+#define CC_PAGEVEC_MAX 64
+
+struct cc_page {
+    pthread_mutex_t lock;
+    int frame;
+    int valid;
+    int on_swap;
+};
+
+struct cc_page cc_pages[1024];
+pthread_mutex_t cc_lru_lock = PTHREAD_MUTEX_INITIALIZER;
+int cc_frame_page[256];
+int cc_lru_prev[256];
+int cc_lru_next[256];
+int cc_on_lru[256];
+int cc_lru_head = -1;               /* most recently used */
+int cc_lru_tail = -1;
+int cc_free[256];
+int cc_free_count = 0;
+char* cc_frame_data = NULL;
+char* cc_swap_data = NULL;
+unsigned long cc_page_bytes = 0;
+
+struct cc_thread {
+    pthread_t thread;
+    int id;
+    char* name;
+    long refs;
+    long hits;
+    long faults;
+    long evictions;
+    long page_locks;
+    long page_contended;
+    long lru_locks;
+    long lru_contended;
+    int pagevec[CC_PAGEVEC_MAX];
+    int pagevec_count;
+};
+
+/* Lock m, counting the acquisition and whether it had to wait */
+void cc_lock(pthread_mutex_t* m, long* taken, long* contended) {
+    (*taken)++;
+    if (pthread_mutex_trylock(m) == 0) return;
+    (*contended)++;
+    pthread_mutex_lock(m);
+}
+
+void cc_lru_unlink(int f) {
+    if (cc_lru_prev[f] >= 0) cc_lru_next[cc_lru_prev[f]] = cc_lru_next[f];
+    else cc_lru_head = cc_lru_next[f];
+    if (cc_lru_next[f] >= 0) cc_lru_prev[cc_lru_next[f]] = cc_lru_prev[f];
+    else cc_lru_tail = cc_lru_prev[f];
+    cc_on_lru[f] = 0;
+}
+
+void cc_lru_push_head(int f) {
+    cc_lru_prev[f] = -1;
+    cc_lru_next[f] = cc_lru_head;
+    if (cc_lru_head >= 0) cc_lru_prev[cc_lru_head] = f;
+    cc_lru_head = f;
+    if (cc_lru_tail < 0) cc_lru_tail = f;
+    cc_on_lru[f] = 1;
+}
+
+/* Frames queued here may have been evicted since; rotating one that is
+ * off the list is skipped, and one reused by another page only costs that
+ * page a little extra recency */
+void cc_pagevec_drain(struct cc_thread* t) {
+    int i, f;
+    if (t->pagevec_count == 0) return;
+    cc_lock(&cc_lru_lock, &t->lru_locks, &t->lru_contended);
+    for (i = 0; i < t->pagevec_count; i++) {
+        f = t->pagevec[i];
+        if (cc_on_lru[f] && f != cc_lru_head) {
+            cc_lru_unlink(f);
+            cc_lru_push_head(f);
+        }
+    }
+    pthread_mutex_unlock(&cc_lru_lock);
+    t->pagevec_count = 0;
+}
+
+void cc_mark_accessed(struct cc_thread* t, int f) {
+    t->pagevec[t->pagevec_count++] = f;
+    if (t->pagevec_count >= concurrent_pagevec) cc_pagevec_drain(t);
+}
+
+/* Called with the faulting page locked: pop a free frame, or take the
+ * least recently used frame whose page can be locked without waiting and
+ * write that page to swap */
+int cc_get_frame(struct cc_thread* t) {
+    int f, victim = -1;
+    
+    while (1) {
+        cc_lock(&cc_lru_lock, &t->lru_locks, &t->lru_contended);
+        if (cc_free_count > 0) {
+            f = cc_free[--cc_free_count];
+            pthread_mutex_unlock(&cc_lru_lock);
+            return f;
+        }
+        for (f = cc_lru_tail; f >= 0; f = cc_lru_prev[f]) {
+            victim = cc_frame_page[f];
+            t->page_locks++;
+            if (pthread_mutex_trylock(&cc_pages[victim].lock) == 0) break;
+            t->page_contended++;
+        }
+        if (f >= 0) cc_lru_unlink(f);
+        pthread_mutex_unlock(&cc_lru_lock);
+        if (f >= 0) break;
+        /* Every resident page is busy or mid-fault; let their owners run */
+        sched_yield();
+    }
+    
+    memcpy(cc_swap_data + (long)victim * cc_page_bytes, cc_frame_data + (long)f * cc_page_bytes, cc_page_bytes);
+    cc_pages[victim].on_swap = 1;
+    cc_pages[victim].valid = 0;
+    cc_pages[victim].frame = -1;
+    pthread_mutex_unlock(&cc_pages[victim].lock);
+    t->evictions++;
+    return f;
+}
+
+void cc_access(struct cc_thread* t, int page) {
+    struct cc_page* p = &cc_pages[page];
+    char* mem;
+    int f;
+    
+    cc_lock(&p->lock, &t->page_locks, &t->page_contended);
+    if (p->valid) {
+        f = p->frame;
+        cc_frame_data[(long)f * cc_page_bytes]++;
+        pthread_mutex_unlock(&p->lock);
+        t->hits++;
+        if (concurrent_pagevec > 1) {
+            cc_mark_accessed(t, f);
+        } else {
+            cc_lock(&cc_lru_lock, &t->lru_locks, &t->lru_contended);
+            if (cc_on_lru[f] && f != cc_lru_head) {
+                cc_lru_unlink(f);
+                cc_lru_push_head(f);
+            }
+            pthread_mutex_unlock(&cc_lru_lock);
+        }
+        return;
+    }
+    
+    t->faults++;
+    f = cc_get_frame(t);
+    mem = cc_frame_data + (long)f * cc_page_bytes;
+    if (p->on_swap) memcpy(mem, cc_swap_data + (long)page * cc_page_bytes, cc_page_bytes);
+    else memset(mem, 0, cc_page_bytes);
+    mem[0]++;
+    p->frame = f;
+    p->valid = 1;
+    
+    cc_lock(&cc_lru_lock, &t->lru_locks, &t->lru_contended);
+    cc_frame_page[f] = page;
+    cc_lru_push_head(f);
+    pthread_mutex_unlock(&cc_lru_lock);
+    pthread_mutex_unlock(&p->lock);
+}
+
+void* cc_worker(void* arg) {
+    struct cc_thread* t = arg;
+    struct workload wl;
+    int buf[WL_BATCH];
+    int num_pages = workload_pages > 0 ? workload_pages : total_frames * 3;
+    int n, i;
+    
+    if (num_pages > 1024) num_pages = 1024;
+    if (!workload_init(&wl, workload_spec_for(t->name), num_pages, concurrent_refs,
+                       wl_split(wl_split(workload_seed, hash_string(t->name)), t->id))) {
+        workload_init(&wl, "uniform", num_pages, concurrent_refs,
+                      wl_split(wl_split(workload_seed, hash_string(t->name)), t->id));
+    }
+    while ((n = workload_fill(&wl, buf, WL_BATCH)) > 0) {
+        for (i = 0; i < n; i++) cc_access(t, buf[i]);
+        t->refs += n;
+    }
+    cc_pagevec_drain(t);
+    return NULL;
+}
+
+void cc_reset(void) {
+    int i;
+    for (i = 0; i < 1024; i++) {
+        cc_pages[i].frame = -1;
+        cc_pages[i].valid = 0;
+        cc_pages[i].on_swap = 0;
+    }
+    for (i = 0; i < total_frames; i++) {
+        cc_free[i] = total_frames - 1 - i;
+        cc_on_lru[i] = 0;
+        cc_frame_page[i] = -1;
+    }
+    cc_free_count = total_frames;
+    cc_lru_head = -1;
+    cc_lru_tail = -1;
+}
+
+int run_concurrent(char* match) {
+    struct cc_thread* threads;
+    char* name = NULL;
+    double base_rate = 0.0;
+    int i, n, k, last = 0;
+    
+    for (i = 0; i < NUM_PROGRAMS && !name; i++) {
+        if (!match || strstr(program_sources[i], match)) name = program_name(i);
+    }
+    if (!name) {
+        printf("Error: no program matches '%s'\n", match);
+        return 1;
+    }
+    if (concurrent_max_threads < 1) concurrent_max_threads = 1;
+    if (concurrent_max_threads > CC_MAX_THREADS) concurrent_max_threads = CC_MAX_THREADS;
+    if (concurrent_pagevec > CC_PAGEVEC_MAX) concurrent_pagevec = CC_PAGEVEC_MAX;
+    
+    cc_page_bytes = (unsigned long)page_size_kb * 1024;
+    cc_frame_data = calloc(total_frames, cc_page_bytes);
+    cc_swap_data = calloc(1024, cc_page_bytes);
+    threads = calloc(CC_MAX_THREADS, sizeof(*threads));
+    if (!cc_frame_data || !cc_swap_data || !threads) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < 1024; i++) pthread_mutex_init(&cc_pages[i].lock, NULL);
+    
+    printf("Virtual Memory Manager - Concurrent Fault Handling\n");
+    printf("==================================================\n");
+    printf("%s workload, %ld refs per thread, %d frames shared, LRU with %s\n",
+           name, concurrent_refs, total_frames,
+           concurrent_pagevec > 1 ? "per-thread pagevecs" : "a lock per hit");
+    if (concurrent_pagevec > 1) printf("Pagevec size %d\n", concurrent_pagevec);
+    printf("\nThreads   Refs/s (M)  Speedup   Faults  Evictions  Page Lock Wait  LRU Locks/1k  LRU Lock Wait\n");
+    printf("-----------------------------------------------------------------------------------------------\n");
     
-    snprintf(command, sizeof(command), "gcc -o %s %s 2>/dev/null", output_path, source_path);
-    result = system(command);
+    for (n = 1; !last; n *= 2) {
+        long refs = 0, faults = 0, evictions = 0;
+        long page_locks = 0, page_contended = 0, lru_locks = 0, lru_contended = 0;
+        double start, elapsed, rate;
+        int started = 0;
+        
+        if (n >= concurrent_max_threads) {
+            n = concurrent_max_threads;
+            last = 1;
+        }
+        cc_reset();
+        memset(threads, 0, CC_MAX_THREADS * sizeof(*threads));
+        start = get_time_ms();
+        for (k = 0; k < n; k++) {
+            threads[k].id = k;
+            threads[k].name = name;
+            if (pthread_create(&threads[k].thread, NULL, cc_worker, &threads[k]) != 0) break;
+            started++;
+        }
+        for (k = 0; k < started; k++) pthread_join(threads[k].thread, NULL);
+        elapsed = get_time_ms() - start;
+        
+        for (k = 0; k < started; k++) {
+            refs += threads[k].refs;
+            faults += threads[k].faults;
+            evictions += threads[k].evictions;
+            page_locks += threads[k].page_locks;
+            page_contended += threads[k].page_contended;
+            lru_locks += threads[k].lru_locks;
+            lru_contended += threads[k].lru_contended;
+        }
+        rate = elapsed > 0 ? refs / (elapsed * 1000.0) : 0.0;
+        if (n == 1) base_rate = rate;
+        printf("%7d %12.2f %7.2fx %8ld %10ld %14.2f%% %13.1f %13.2f%%\n",
+               started, rate, base_rate > 0 ? rate / base_rate : 0.0, faults, evictions,
+               page_locks > 0 ? 100.0 * page_contended / page_locks : 0.0,
+               refs > 0 ? 1000.0 * lru_locks / refs : 0.0,
+               lru_locks > 0 ? 100.0 * lru_contended / lru_locks : 0.0);
+        if (started < n) {
+            printf("  (only %d of %d threads could be created)\n", started, n);
+            break;
+        }
+    }
+    printf("\n%ld online CPUs; lock wait is the share of acquisitions that found the lock held\n",
+           sysconf(_SC_NPROCESSORS_ONLN));
     
-    return (result == 0);
+    for (i = 0; i < 1024; i++) pthread_mutex_destroy(&cc_pages[i].lock);
+    free(threads);
+    free(cc_frame_data);
+    free(cc_swap_data);
+    return 0;
 }
 
-int main(void) {
+int main(int argc, char** argv) {
     FILE *config;
     struct program_info programs[10];
-    char source_paths[10][256] = {
-        "programs/sequential_access.c", "programs/random_access.c",
-        "programs/matrix_multiply.c", "programs/linked_list.c",
-        "programs/bubble_sort.c", "programs/stack_operations.c",
-        "programs/binary_search.c", "programs/string_processing.c",
-        "programs/hash_table.c", "programs/recursion.c"
-    };
+    char** source_paths = program_sources;
     char binary_paths[10][256];
+    char object_paths[10][256];
+    struct build_job jobs[MAX_BUILD_JOBS];
+    int njobs, built;
+    FILE* mrc_csv = NULL;
     int i;
     
     /* Initialize programs array to zero */
@@ -1068,8 +7511,17 @@ int main(void) {
     }
     fscanf(config, "%d", &mem_size_kb);
     fscanf(config, "%d", &page_size_kb);
+    read_config_options(config);
     fclose(config);
     
+    if (argc > 1 && !(argc == 3 && strcmp(argv[1], "--sweep") == 0) &&
+        !(argc <= 3 && strcmp(argv[1], "--concurrent") == 0)) {
+        printf("Usage: %s [--sweep <file> | --concurrent [program]]\n", argv[0]);
+        return 1;
+    }
+    live_open();
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) return run_sweep(argv[2]);
+    
     total_frames = mem_size_kb / page_size_kb;
     
     if (total_frames > 256) {
@@ -1078,6 +7530,8 @@ int main(void) {
         return 1;
     }
     
+    if (argc > 1) return run_concurrent(argc == 3 ? argv[2] : "hash_table");
+    
     printf("Virtual Memory Manager - Algorithm Comparison\n");
     printf("=============================================\n");
     printf("Config: %d KB memory, %d KB pages, %d frames\n", 
@@ -1086,23 +7540,43 @@ int main(void) {
     printf("  - FIFO:  First-In-First-Out (simulated)\n");
     printf("  - LRU:   Least Recently Used (simulated)\n");
     printf("  - Clock: Second-Chance Algorithm (simulated)\n");
+    printf("  - Aging: %d-bit NFU counters, tick every %ld refs (simulated)\n",
+           aging_bits, aging_interval);
+    printf("  - MGLRU: %d+ generations, refault-driven tier protection (simulated)\n", MGLRU_MIN_GENS);
+    printf("  - LeCaR: LRU/LFU experts reweighted on ghost hits, rate %.2f (simulated)\n", lecar_rate);
     printf("  - Linux: Native kernel memory management\n");
     printf("\nAll use identical synthetic workloads for fair comparison.\n\n");
     
     printf("Compiling programs...\n");
+    njobs = 0;
     for (i = 0; i < 10; i++) {
         snprintf(binary_paths[i], 256, "programs/prog%d.out", i);
-        if (!compile_program(source_paths[i], binary_paths[i])) {
-            printf("  Warning: Failed to compile %s\n", source_paths[i]);
+        add_compile_job(&jobs[njobs++], source_paths[i], binary_paths[i]);
+        snprintf(object_paths[i], 256, "programs/prog%d.so", i);
+        if (pager_enabled) add_pager_object_job(&jobs[njobs++], source_paths[i], object_paths[i]);
+    }
+    built = run_build_jobs(jobs, njobs);
+    for (i = 0; i < njobs; i++) {
+        if (!jobs[i].ok) printf("  Warning: Failed to build %s from %s\n", jobs[i].output, jobs[i].source);
+    }
+    printf("  %d built, %d up to date\n", built, njobs - built);
+    
+    if (mrc_enabled) {
+        mrc_csv = fopen("mrc.csv", "w");
+        if (mrc_csv) {
+            fprintf(mrc_csv, "program,frames,fifo,lru,clock,exact_fifo,exact_lru,exact_clock\n");
         }
     }
     
+    /* Resolves the kswapd watermarks and swap layout the report prints,
+     * even when every run comes from the result cache */
+    init_memory();
+    
     printf("\nRunning comparisons...\n");
-    printf("Each test: Linux native vs Your algos (FIFO/LRU/Clock)\n");
-    printf("------------------------------------------------------\n");
+    printf("Each test: Linux native vs Your algos (FIFO/LRU/Clock/Aging/MGLRU/LeCaR)\n");
+    printf("------------------------------------------------------------------------\n");
     for (i = 0; i < 10; i++) {
-        char *name = strrchr(source_paths[i], '/');
-        name = name ? name + 1 : source_paths[i];
+        char *name = program_name(i);
         
         printf("  [%d/10] %s ", i+1, name);
         fflush(stdout);
@@ -1120,8 +7594,32 @@ int main(void) {
         fflush(stdout);
         
         run_algo(name, mem_size_kb, &programs[i], binary_paths[i], 2);
+        printf(".");
+        fflush(stdout);
+        
+        run_algo(name, mem_size_kb, &programs[i], binary_paths[i], 3);
+        printf(".");
+        fflush(stdout);
+        
+        run_algo(name, mem_size_kb, &programs[i], binary_paths[i], 4);
+        printf(".");
+        fflush(stdout);
+        
+        run_algo(name, mem_size_kb, &programs[i], binary_paths[i], 5);
+        warm_discard();
+        if (pager_enabled) {
+            printf(".");
+            fflush(stdout);
+            run_pager(object_paths[i], &programs[i]);
+        }
+        if (mrc_enabled) {
+            printf(".");
+            fflush(stdout);
+            run_mrc(name, binary_paths[i], &programs[i], mrc_csv);
+        }
         printf(". Done\n");
     }
+    if (mrc_csv) fclose(mrc_csv);
     
     print_results(programs, 10);
     print_memory_map();
@@ -1134,10 +7632,10 @@ int main(void) {
         }
     }
     
-    if (disk_store) {
-        fclose(disk_store);
-        disk_store = NULL;
-    }
+    free(tier2_memory);
+    free(tier2_scratch);
+    
+    swap_areas_close();
     
     return 0;
 }
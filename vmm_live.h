@@ -0,0 +1,41 @@
+/*
+ * Layout of the live counters segment shared by vmm (writer) and vmmtop
+ * (reader).  Bump LIVE_VERSION with any change here; vmmtop refuses a
+ * segment of another version.
+ */
+#ifndef VMM_LIVE_H
+#define VMM_LIVE_H
+
+#define LIVE_SHM_NAME "/vmm_live"
+#define LIVE_MAGIC "VMMLIVE"
+#define LIVE_VERSION 1
+#define LIVE_SLOTS 65           /* comparison runs, then one per sweep worker */
+
+struct live_slot {
+    long pid;                   /* 0 = never used */
+    long state;                 /* 1 running, 2 finished */
+    long run;                   /* bumped at the start of every run */
+    long policy;
+    char program[32];
+    long refs;                  /* references simulated so far */
+    long total_refs;
+    long faults;
+    long swaps;
+    long swap_ins;
+    long free_frames;
+    long frames;
+    long window_refs;           /* last complete window of live_window references */
+    long window_faults;
+    long updated_ms;
+    long latency_hist[128];     /* swap and file I/O, same buckets as latency_record() */
+};
+
+struct live_stats {
+    char magic[8];
+    long version;
+    long pid;                   /* the vmm that created the segment */
+    long started_ms;
+    struct live_slot slot[LIVE_SLOTS];
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include "vmm_live.h"
+
+/*
+ * vmmtop: watch a running vmm through its live counters segment
+ * ("live_stats 1" in vmm's config.txt).
+ *
+ *   ./vmmtop [seconds]
+ *
+ * Redraws every <seconds> (default 1); 0 prints one snapshot and exits.
+ */
+char* policy_names[] = {"FIFO", "LRU", "Clock", "Aging", "MGLRU", "LeCaR"};
+
+long now_ms(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+/* Map the segment read-only; NULL until a vmm has created it */
+struct live_stats* live_attach(void) {
+    struct live_stats* live;
+    void* p;
+    int fd = shm_open(LIVE_SHM_NAME, O_RDONLY, 0);
+
+    if (fd < 0) return NULL;
+    p = mmap(NULL, sizeof(struct live_stats), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    live = p;
+    if (memcmp(live->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC)) != 0 || live->version != LIVE_VERSION) {
+        munmap(p, sizeof(struct live_stats));
+        return NULL;
+    }
+    return live;
+}
+
+/* Upper edge of the bucket holding the p-th quantile, in ms (as in vmm.c) */
+double hist_percentile(long* hist, double p) {
+    long total = 0, seen = 0;
+    int b;
+    for (b = 0; b < 128; b++) total += hist[b];
+    if (total == 0) return 0.0;
+    for (b = 0; b < 128; b++) {
+        seen += hist[b];
+        if (seen >= p * total) break;
+    }
+    return pow(2.0, b / 4.0) / 1000.0;
+}
+
+void print_slot(int n, struct live_slot* ls, long now) {
+    long hist[128];
+    long refs, total, faults, wrefs, wfaults, policy, state;
+    char progress[16], window[16], policy_name[8];
+    int b;
+
+    state = __atomic_load_n(&ls->state, __ATOMIC_ACQUIRE);
+    refs = __atomic_load_n(&ls->refs, __ATOMIC_RELAXED);
+    total = __atomic_load_n(&ls->total_refs, __ATOMIC_RELAXED);
+    faults = __atomic_load_n(&ls->faults, __ATOMIC_RELAXED);
+    wrefs = __atomic_load_n(&ls->window_refs, __ATOMIC_RELAXED);
+    wfaults = __atomic_load_n(&ls->window_faults, __ATOMIC_RELAXED);
+    policy = __atomic_load_n(&ls->policy, __ATOMIC_RELAXED);
+    for (b = 0; b < 128; b++) hist[b] = __atomic_load_n(&ls->latency_hist[b], __ATOMIC_RELAXED);
+
+    if (state == 2) snprintf(progress, sizeof(progress), "done");
+    else if (total > 0) snprintf(progress, sizeof(progress), "%.1f%%", 100.0 * refs / total);
+    else snprintf(progress, sizeof(progress), "-");
+    if (wrefs > 0) snprintf(window, sizeof(window), "%.2f%%", 100.0 * wfaults / wrefs);
+    else snprintf(window, sizeof(window), "-");
+    if (policy >= 0 && policy < 6) snprintf(policy_name, sizeof(policy_name), "%s", policy_names[policy]);
+    else snprintf(policy_name, sizeof(policy_name), "?");
+
+    printf("%4d %7ld %-20.20s %-6s %7s %10ld %9ld %6.2f%% %8s %8ld %8ld %5ld/%-4ld %8.3f %8.3f %5.1fs\n",
+           n, ls->pid, ls->program, policy_name, progress, refs, faults,
+           refs > 0 ? 100.0 * (refs - faults) / refs : 0.0, window,
+           __atomic_load_n(&ls->swaps, __ATOMIC_RELAXED),
+           __atomic_load_n(&ls->swap_ins, __ATOMIC_RELAXED),
+           __atomic_load_n(&ls->free_frames, __ATOMIC_RELAXED),
+           __atomic_load_n(&ls->frames, __ATOMIC_RELAXED),
+           hist_percentile(hist, 0.50), hist_percentile(hist, 0.99),
+           (now - __atomic_load_n(&ls->updated_ms, __ATOMIC_RELAXED)) / 1000.0);
+}
+
+/* Print one screen; returns 0 once the vmm that owns the segment is gone */
+int print_live(struct live_stats* live) {
+    long now = now_ms();
+    int n, alive = kill((pid_t)live->pid, 0) == 0 || errno == EPERM;
+
+    printf("vmm pid %ld, %s, up %.0fs\n\n", live->pid, alive ? "running" : "exited",
+           (now - live->started_ms) / 1000.0);
+    printf("%4s %7s %-20s %-6s %7s %10s %9s %7s %8s %8s %8s %10s %8s %8s %6s\n",
+           "Slot", "PID", "Program", "Policy", "Done", "Refs", "Faults", "Hit",
+           "Window", "Swaps", "SwapIns", "Free", "p50 ms", "p99 ms", "Age");
+    for (n = 0; n < LIVE_SLOTS; n++) {
+        if (__atomic_load_n(&live->slot[n].run, __ATOMIC_RELAXED) == 0) continue;
+        print_slot(n, &live->slot[n], now);
+    }
+    printf("\nWindow: fault rate over the last complete live_window references\n");
+    fflush(stdout);
+    return alive;
+}
+
+int main(int argc, char** argv) {
+    struct live_stats* live = NULL;
+    double interval = argc > 1 ? atof(argv[1]) : 1.0;
+    int alive;
+
+    if (argc > 2 || interval < 0) {
+        printf("Usage: %s [seconds]\n", argv[0]);
+        return 1;
+    }
+    for (;;) {
+        if (!live) live = live_attach();
+        if (interval > 0) printf("\033[H\033[2J");
+        if (!live) {
+            printf("Waiting for vmm (no %s segment; is live_stats 1 set?)\n", LIVE_SHM_NAME);
+            fflush(stdout);
+            if (interval == 0) return 1;
+        } else {
+            alive = print_live(live);
+            if (!alive || interval == 0) return 0;
+        }
+        usleep((useconds_t)(interval * 1000000));
+    }
+}